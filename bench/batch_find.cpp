@@ -0,0 +1,69 @@
+/**
+ * Lookups on a read-only btree<long> too big for the caches: a loop of
+ * find() calls against find_batch, which walks the lookups down in groups
+ * and prefetches the nodes they move to. Half the probes hit. Trees of
+ * 1M and 10M keys are timed by default; pass a key count to time that
+ * size instead, e.g. batch_find 100000000.
+ **/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "btree.h"
+
+namespace {
+
+const size_t kProbes = 4000000;
+
+template <typename Lookup>
+double nsPerProbe(Lookup lookup) {
+  auto start = std::chrono::steady_clock::now();
+  lookup();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / kProbes;
+}
+
+void timeTree(size_t elemCount) {
+  std::mt19937_64 rng(6771);
+  std::vector<long> elems(elemCount);
+  for (long& elem : elems) elem = static_cast<long>(rng() >> 1);
+  const btree<long> tree(elems.begin(), elems.end());
+  std::vector<long> probes(kProbes);
+  for (size_t i = 0; i < kProbes; ++i) {
+    probes[i] = (i % 2 == 0) ? elems[rng() % elemCount]
+                             : static_cast<long>(rng() >> 1);
+  }
+  elems = std::vector<long>();
+  std::vector<const long*> found(kProbes);
+
+  double loop = nsPerProbe([&]() {
+    for (size_t i = 0; i < kProbes; ++i) {
+      auto iter = tree.find(probes[i]);
+      found[i] = (iter == tree.cend()) ? nullptr : &*iter;
+    }
+  });
+  std::cout << "find loop," << elemCount << "," << loop << std::endl;
+
+  double batch = nsPerProbe([&]() {
+    tree.find_batch(probes.begin(), probes.end(), found.begin());
+  });
+  std::cout << "find_batch," << elemCount << "," << batch << std::endl;
+}
+
+}  // namespace close
+
+int main(int argc, char **argv) {
+  std::cout << "lookup,keys,ns_per_probe" << std::endl;
+  if (argc > 1) {
+    timeTree(std::strtoul(argv[1], nullptr, 10));
+  } else {
+    timeTree(1000000);
+    timeTree(10000000);
+  }
+
+  return 0;
+}
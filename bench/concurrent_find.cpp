@@ -0,0 +1,116 @@
+/**
+ * Read throughput with one writer inserting all along: concurrent_btree's
+ * lock-free readers against a btree<long> behind one global mutex, the
+ * way it is shared today. Each run preloads a million random keys, starts
+ * the writer, and counts the finds the readers get through in a fixed
+ * time for 1, 2, 4, ... readers up to the number of hardware threads.
+ **/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "btree.h"
+#include "concurrent_btree.h"
+
+namespace {
+
+const size_t kPreloaded = 1000000;
+const size_t kProbes = 1 << 20;
+const std::chrono::milliseconds kRunTime(500);
+
+std::vector<long> randomValues(std::mt19937_64& rng, size_t count) {
+  std::vector<long> values;
+  values.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    values.push_back(static_cast<long>(rng() % 1000000000));
+  }
+  return values;
+}
+
+/**
+ * Runs readers threads calling find(probe) over their share of probes
+ * and one thread calling insert(value) until time is up. Returns the
+ * finds per second and the inserts per second.
+ **/
+template <typename Find, typename Insert>
+std::pair<double, double> run(size_t readers, const std::vector<long>& probes
+                            , const std::vector<long>& values
+                            , Find find, Insert insert) {
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> finds{0};
+  std::atomic<size_t> inserts{0};
+  std::vector<std::thread> threads;
+  for (size_t r = 0; r < readers; ++r) {
+    threads.emplace_back([&, r]() {
+      size_t done = 0;
+      size_t hits = 0;
+      for (size_t i = r * 7919; !stop.load(std::memory_order_relaxed); ++i) {
+        hits += find(probes[i % probes.size()]);
+        ++done;
+      }
+      finds += done;
+      if (hits == static_cast<size_t>(-1)) std::cout << "";
+    });
+  }
+  threads.emplace_back([&]() {
+    size_t done = 0;
+    for (size_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+      insert(values[i % values.size()]);
+      ++done;
+    }
+    inserts += done;
+  });
+
+  std::this_thread::sleep_for(kRunTime);
+  stop = true;
+  for (auto& thread : threads) thread.join();
+  double seconds = std::chrono::duration<double>(kRunTime).count();
+  return std::make_pair(finds / seconds, inserts / seconds);
+}
+
+}  // namespace close
+
+int main(void) {
+  std::mt19937_64 rng(6771);
+  std::vector<long> preload = randomValues(rng, kPreloaded);
+  std::vector<long> probes = randomValues(rng, kProbes);
+  std::copy(preload.begin(), preload.begin() + kProbes / 2, probes.begin());
+  std::shuffle(probes.begin(), probes.end(), rng);
+  std::vector<long> values = randomValues(rng, 4 * kPreloaded);
+
+  size_t maxReaders = std::max(1u, std::thread::hardware_concurrency());
+  std::cout << "tree,readers,finds_per_s,inserts_per_s" << std::endl;
+  for (size_t readers = 1; readers <= maxReaders; readers *= 2) {
+    btree<long> locked;
+    locked.insert(preload.begin(), preload.end());
+    std::mutex mutex;
+    auto lockedRun = run(readers, probes, values
+                       , [&](long probe) {
+                             std::lock_guard<std::mutex> guard(mutex);
+                             return locked.find(probe) != locked.end();
+                         }
+                       , [&](long value) {
+                             std::lock_guard<std::mutex> guard(mutex);
+                             locked.insert(value);
+                         });
+    std::cout << "mutex+btree<long>," << readers << "," << lockedRun.first
+              << "," << lockedRun.second << std::endl;
+
+    concurrent_btree<long> shared;
+    for (long value : preload) shared.insert(value);
+    auto sharedRun = run(readers, probes, values
+                       , [&](long probe) { return shared.contains(probe); }
+                       , [&](long value) { shared.insert(value); });
+    std::cout << "concurrent_btree<long>," << readers << ","
+              << sharedRun.first << "," << sharedRun.second << std::endl;
+  }
+
+  return 0;
+}
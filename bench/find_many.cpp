@@ -0,0 +1,64 @@
+/**
+ * Batch lookups on a read-only btree<long>: a loop of find() calls, as
+ * test01's confirmEverythingMatches does, against find_many on pools of
+ * 1, 2, 4, ... threads up to the number of hardware threads. Half the
+ * probes hit.
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "btree.h"
+
+namespace {
+
+const size_t kElems = 4000000;
+const size_t kProbes = 8000000;
+
+template <typename Lookup>
+double nsPerProbe(Lookup lookup) {
+  auto start = std::chrono::steady_clock::now();
+  lookup();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / kProbes;
+}
+
+}  // namespace close
+
+int main(void) {
+  std::mt19937_64 rng(6771);
+  std::vector<long> elems(kElems);
+  for (long& elem : elems) elem = static_cast<long>(rng() >> 1);
+  const btree<long> tree(elems.begin(), elems.end());
+  std::vector<long> probes(kProbes);
+  for (size_t i = 0; i < kProbes; ++i) {
+    probes[i] = (i % 2 == 0) ? elems[rng() % kElems] 
+                             : static_cast<long>(rng() >> 1);
+  }
+  std::vector<const long*> found(kProbes);
+
+  std::cout << "lookup,threads,ns_per_probe" << std::endl;
+  double loop = nsPerProbe([&]() {
+    for (size_t i = 0; i < kProbes; ++i) {
+      auto iter = tree.find(probes[i]);
+      found[i] = (iter == tree.cend()) ? nullptr : &*iter;
+    }
+  });
+  std::cout << "find loop,1," << loop << std::endl;
+
+  size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    btree_thread_pool pool(threads - 1);
+    double batch = nsPerProbe([&]() {
+      tree.find_many(probes.begin(), probes.end(), found.begin(), pool);
+    });
+    std::cout << "find_many," << threads << "," << batch << std::endl;
+  }
+
+  return 0;
+}
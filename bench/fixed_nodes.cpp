@@ -0,0 +1,67 @@
+/**
+ * Node capacity chosen at run time against fixed at compile time: random
+ * inserts and finds on a million keys for btree<T>(40), fixed_btree<T, 40>
+ * and a tree fitted to 512-byte leaves, with long keys and with string
+ * keys. Strings take the three-way search that a fixed capacity
+ * unrolls; longs keep the vector kernel either way.
+ **/
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+
+namespace {
+
+const size_t kKeys = 1000000;
+
+template <typename Run>
+double seconds(Run run) {
+  auto start = std::chrono::steady_clock::now();
+  run();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double>(elapsed).count();
+}
+
+template <typename Tree, typename K>
+void run(const char *name, const char *key, Tree tree
+       , const std::vector<K>& keys) {
+  double insert = seconds([&]() {
+    for (const K& k : keys) tree.insert(k);
+  });
+  size_t found = 0;
+  double find = seconds([&]() {
+    for (const K& k : keys) found += tree.find(k) != tree.end();
+  });
+  std::cout << name << "," << key << "," << insert / keys.size() * 1e9 << ","
+            << find / keys.size() * 1e9 << "," << found << std::endl;
+}
+
+template <typename K>
+void runAll(const char *key, const std::vector<K>& keys) {
+  typedef btree<K, std::less<K>, std::allocator<K>
+              , btree_fitted_policy<>> fitted;
+  run("btree(40)", key, btree<K>(40), keys);
+  run("fixed_btree<40>", key, fixed_btree<K, 40>(), keys);
+  run("fitted<512>", key, fitted(), keys);
+}
+
+}  // namespace close
+
+int main(void) {
+  std::mt19937_64 rng(6771);
+  std::vector<long> numbers(kKeys);
+  for (long& number : numbers) number = static_cast<long>(rng() >> 1);
+  std::vector<std::string> words;
+  for (long number : numbers) words.push_back(std::to_string(number));
+
+  std::cout << "tree,key,insert_ns,find_ns,found" << std::endl;
+  runAll("long", numbers);
+  runAll("string", words);
+  return 0;
+}
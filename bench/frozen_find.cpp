@@ -0,0 +1,84 @@
+/**
+ * A read-only phase after a build: random finds in a btree<T>, in the
+ * frozen_btree freeze() makes of it, and with std::lower_bound over a
+ * sorted vector, for 1M and 10M longs and 1M strings. Also prints the
+ * bytes each takes per key, not counting the strings' own buffers.
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+
+namespace {
+
+const size_t kProbes = 2000000;
+
+template <typename Run>
+double seconds(Run run) {
+  auto start = std::chrono::steady_clock::now();
+  run();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double>(elapsed).count();
+}
+
+template <typename Find, typename K>
+void report(const char *name, const char *key, size_t size
+          , double bytesPerKey, const std::vector<K>& probes, Find find) {
+  size_t found = 0;
+  double elapsed = seconds([&]() {
+    for (const K& probe : probes) found += find(probe);
+  });
+  std::cout << name << "," << key << "," << size << "," << bytesPerKey << ","
+            << elapsed / probes.size() * 1e9 << "," << found << std::endl;
+}
+
+template <typename K>
+void runAll(const char *key, const std::vector<K>& keys
+          , const std::vector<K>& probes) {
+  btree<K> tree(keys.begin(), keys.end());
+  frozen_btree<K> frozen = tree.freeze();
+  std::vector<K> sorted(tree.begin(), tree.end());
+
+  report("btree", key, tree.size(), tree.stats().bytesPerKey, probes
+       , [&](const K& probe) { return tree.find(probe) != tree.end(); });
+  report("frozen_btree", key, frozen.size()
+       , static_cast<double>(frozen.bytes()) / frozen.size(), probes
+       , [&](const K& probe) { return frozen.contains(probe); });
+  report("sorted_vector", key, sorted.size(), sizeof(K), probes
+       , [&](const K& probe) {
+           return std::binary_search(sorted.begin(), sorted.end(), probe);
+         });
+}
+
+}  // namespace close
+
+int main(void) {
+  std::mt19937_64 rng(6771);
+  std::cout << "container,key,size,bytes_per_key,find_ns,found" << std::endl;
+  for (size_t size : {1000000, 10000000}) {
+    std::vector<long> numbers(size);
+    for (long& number : numbers) number = static_cast<long>(rng() >> 1);
+    std::vector<long> probes;
+    for (size_t i = 0; i < kProbes; ++i) {
+      probes.push_back(i % 2 == 0 ? numbers[rng() % size]
+                                  : static_cast<long>(rng() >> 1));
+    }
+    runAll("long", numbers, probes);
+  }
+
+  std::vector<std::string> words(1000000);
+  for (std::string& word : words) word = std::to_string(rng() >> 1);
+  std::vector<std::string> wordProbes;
+  for (size_t i = 0; i < kProbes / 4; ++i) {
+    wordProbes.push_back(i % 2 == 0 ? words[rng() % words.size()]
+                                    : std::to_string(rng() >> 1));
+  }
+  runAll("string", words, wordProbes);
+  return 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * Startup cost of a large read-only set of long keys: building a btree
+ * from the sorted keys against mapping a saved one, and the time of the
+ * first lookups after opening, while the pages they touch are still being
+ * faulted in, against the same lookups in the built tree. Lookups after
+ * that, with the mapping warm, are timed for both too.
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "btree.h"
+#include "mapped_btree.h"
+
+namespace {
+
+const size_t kElems = 10000000;
+const size_t kProbes = 1000000;
+const char kPath[] = "bench_mapped_open.map";
+
+template <typename Run>
+double seconds(Run run) {
+  auto start = std::chrono::steady_clock::now();
+  run();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double>(elapsed).count();
+}
+
+template <typename Tree>
+size_t lookups(const Tree& tree, const std::vector<long>& probes) {
+  size_t found = 0;
+  for (long probe : probes) found += tree.find(probe) != tree.end();
+  return found;
+}
+
+}  // namespace close
+
+int main(void) {
+  std::mt19937_64 rng(6771);
+  std::vector<long> elems(kElems);
+  for (long& elem : elems) elem = static_cast<long>(rng() >> 1);
+  std::sort(elems.begin(), elems.end());
+  elems.erase(std::unique(elems.begin(), elems.end()), elems.end());
+  std::vector<long> probes(kProbes);
+  for (long& probe : probes) probe = elems[rng() % elems.size()];
+  btree<long>(elems.begin(), elems.end()).save(kPath);
+
+  std::cout << "tree,operation,seconds" << std::endl;
+  size_t found = 0;
+  {
+    btree<long> *tree = nullptr;
+    double open = seconds([&]() {
+      tree = new btree<long>(elems.begin(), elems.end());
+    });
+    double cold = seconds([&]() { found += lookups(*tree, probes); });
+    double warm = seconds([&]() { found += lookups(*tree, probes); });
+    std::cout << "btree<long>,open," << open << std::endl
+              << "btree<long>,first_lookups," << cold << std::endl
+              << "btree<long>,lookups," << warm << std::endl;
+    delete tree;
+  }
+  {
+    mapped_btree<long> *tree = nullptr;
+    double open = seconds([&]() { tree = new mapped_btree<long>(kPath); });
+    double cold = seconds([&]() { found += lookups(*tree, probes); });
+    double warm = seconds([&]() { found += lookups(*tree, probes); });
+    std::cout << "mapped_btree<long>,open," << open << std::endl
+              << "mapped_btree<long>,first_lookups," << cold << std::endl
+              << "mapped_btree<long>,lookups," << warm << std::endl;
+    delete tree;
+  }
+  std::remove(kPath);
+  return found == 4 * kProbes ? 0 : 1;
+}
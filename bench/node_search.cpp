@@ -0,0 +1,101 @@
+/**
+ * Compares the scalar binary search against the vector kernel picked for
+ * T when searching a single node, at the node sizes we actually use, and
+ * times whole-tree find() for btree<long> at the same sizes. Build with
+ * -DBTREE_NO_SIMD to get the tree numbers for the scalar path.
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "btree.h"
+
+namespace {
+
+const size_t kProbes = 4000000;
+const size_t kNodes = 1024;
+
+template <typename T>
+std::vector<T> randomValues(std::mt19937_64& rng, size_t count) {
+  std::vector<T> values;
+  values.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    values.push_back(static_cast<T>(rng() % 1000000000));
+  }
+  return values;
+}
+
+template <typename Search>
+double nsPerProbe(Search search) {
+  auto start = std::chrono::steady_clock::now();
+  size_t sink = search();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  if (sink == static_cast<size_t>(-1)) std::cout << "";
+  return std::chrono::duration<double, std::nano>(elapsed).count() / kProbes;
+}
+
+/**
+ * Lays out kNodes sorted nodes of the given size back to back, as they
+ * would sit in the tree, and probes random nodes with random keys.
+ **/
+template <typename T>
+void benchNodes(const char *type, size_t nodeSize, std::mt19937_64& rng) {
+  std::vector<T> keys = randomValues<T>(rng, kNodes * nodeSize);
+  for (size_t n = 0; n < kNodes; ++n) {
+    std::sort(keys.begin() + n * nodeSize, keys.begin() + (n + 1) * nodeSize);
+  }
+  std::vector<T> probes = randomValues<T>(rng, kProbes);
+  std::vector<size_t> nodes(kProbes);
+  for (auto& node : nodes) node = rng() % kNodes;
+
+  typedef btree_node_search<T> search;
+  double scalar = nsPerProbe([&]() {
+    size_t sum = 0;
+    for (size_t i = 0; i < kProbes; ++i)
+      sum += search::scalar(&keys[nodes[i] * nodeSize], nodeSize, probes[i]);
+    return sum;
+  });
+  double kernel = nsPerProbe([&]() {
+    size_t sum = 0;
+    for (size_t i = 0; i < kProbes; ++i)
+      sum += search::lowerBound(&keys[nodes[i] * nodeSize], nodeSize, probes[i]);
+    return sum;
+  });
+  std::cout << type << "," << nodeSize << "," << scalar << "," << kernel 
+            << "," << scalar / kernel << std::endl;
+}
+
+void benchTree(size_t nodeSize, std::mt19937_64& rng) {
+  btree<long> b(nodeSize);
+  std::vector<long> values = randomValues<long>(rng, 1000000);
+  for (long value : values) b.insert(value);
+  std::vector<long> probes = randomValues<long>(rng, kProbes);
+  const btree<long>& tree = b;
+  double ns = nsPerProbe([&]() {
+    size_t found = 0;
+    for (long probe : probes) found += (tree.find(probe) != tree.cend());
+    return found;
+  });
+  std::cout << "btree<long>::find," << nodeSize << "," << ns << std::endl;
+}
+
+}  // namespace close
+
+int main(void) {
+  std::mt19937_64 rng(6771);
+  const size_t nodeSizes[] = {16, 32, 64, 128};
+
+  std::cout << "type,node_size,scalar_ns,kernel_ns,speedup" << std::endl;
+  for (size_t nodeSize : nodeSizes) benchNodes<long>("long", nodeSize, rng);
+  for (size_t nodeSize : nodeSizes) benchNodes<int>("int", nodeSize, rng);
+  for (size_t nodeSize : nodeSizes) benchNodes<double>("double", nodeSize, rng);
+
+  std::cout << std::endl << "operation,node_size,ns" << std::endl;
+  for (size_t nodeSize : nodeSizes) benchTree(nodeSize, rng);
+
+  return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * Memory and lookup time of a dictionary of keys with long shared
+ * prefixes, path-like keys built from random words, held in a
+ * btree<std::string> and in a prefix_btree. Memory is counted by
+ * replacing the global operator new, and covers both the nodes and the
+ * strings' own buffers.
+ **/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+#include "prefix_btree.h"
+
+namespace {
+
+const size_t kKeys = 2000000;
+size_t allocated = 0;
+
+template <typename Run>
+double seconds(Run run) {
+  auto start = std::chrono::steady_clock::now();
+  run();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double>(elapsed).count();
+}
+
+std::string randomWord(std::mt19937_64& rng, size_t length) {
+  std::string word(length, 'a');
+  for (char& c : word) c = static_cast<char>('a' + rng() % 26);
+  return word;
+}
+
+/**
+ * Builds a tree of keys, reporting the bytes allocated while it was
+ * built and still held, and the time to look up every probe.
+ **/
+template <typename Build>
+void run(const char *name, const std::vector<std::string>& keys
+       , const std::vector<std::string>& probes, Build build) {
+  size_t before = allocated;
+  auto tree = build(keys);
+  size_t bytes = allocated - before;
+  size_t found = 0;
+  double elapsed = seconds([&]() {
+    for (const std::string& probe : probes) {
+      found += tree.find(probe) != tree.end();
+    }
+  });
+  std::cout << name << "," << bytes / static_cast<double>(keys.size()) << ","
+            << elapsed / probes.size() * 1e9 << "," << found << std::endl;
+}
+
+}  // namespace close
+
+void* operator new(size_t bytes) {
+  allocated += bytes;
+  if (void *block = std::malloc(bytes + sizeof(std::max_align_t))) {
+    *static_cast<size_t*>(block) = bytes;
+    return static_cast<char*>(block) + sizeof(std::max_align_t);
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *block) noexcept {
+  if (block != nullptr) {
+    char *start = static_cast<char*>(block) - sizeof(std::max_align_t);
+    allocated -= *reinterpret_cast<size_t*>(start);
+    std::free(start);
+  }
+}
+
+void operator delete(void *block, size_t) noexcept {
+  operator delete(block);
+}
+
+int main(void) {
+  std::mt19937_64 rng(6771);
+  std::vector<std::string> sections(50);
+  for (std::string& section : sections) section = randomWord(rng, 8);
+  std::vector<std::string> keys(kKeys);
+  for (std::string& key : keys) {
+    key = "/usr/share/dict/" + sections[rng() % sections.size()] + "/"
+        + randomWord(rng, 2) + "/" + randomWord(rng, 3 + rng() % 8);
+  }
+  std::vector<std::string> probes(1000000);
+  for (std::string& probe : probes) probe = keys[rng() % keys.size()];
+
+  std::cout << "tree,bytes_per_key,find_ns,found" << std::endl;
+  run("btree<std::string>", keys, probes
+    , [](const std::vector<std::string>& from) {
+    return btree<std::string>(from.begin(), from.end());
+  });
+  run("prefix_btree", keys, probes
+    , [](const std::vector<std::string>& from) {
+    return prefix_btree(from.begin(), from.end());
+  });
+  return 0;
+}
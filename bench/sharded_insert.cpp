@@ -0,0 +1,75 @@
+/**
+ * Insert throughput on random long keys by thread count: a sharded_btree
+ * with a few shards per thread, set up from a sample of the keys, against
+ * one btree<long> behind a global mutex. Every thread inserts its own
+ * slice of the same key set, so each run does the same total work.
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "btree.h"
+#include "sharded_btree.h"
+
+namespace {
+
+const size_t kKeys = 4000000;
+const size_t kShardsPerThread = 4;
+
+/**
+ * Splits keys between threads, runs insert(key) on each, and returns the
+ * inserts per second.
+ **/
+template <typename Insert>
+double run(size_t threads, const std::vector<long>& keys, Insert insert) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      for (size_t i = t; i < keys.size(); i += threads) {
+        insert(keys[i]);
+      }
+    });
+  }
+  for (auto& worker : workers) worker.join();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return keys.size() / std::chrono::duration<double>(elapsed).count();
+}
+
+}  // namespace close
+
+int main(void) {
+  std::mt19937_64 rng(6771);
+  std::vector<long> keys(kKeys);
+  for (long& key : keys) key = static_cast<long>(rng() >> 1);
+  std::vector<long> sample(keys.begin(), keys.begin() + 10000);
+
+  size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::cout << "tree,threads,inserts_per_s" << std::endl;
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    btree<long> locked;
+    std::mutex mutex;
+    double lockedRate = run(threads, keys, [&](long key) {
+      std::lock_guard<std::mutex> guard(mutex);
+      locked.insert(key);
+    });
+    std::cout << "mutex+btree<long>," << threads << "," << lockedRate
+              << std::endl;
+
+    sharded_btree<long> sharded(sample.begin(), sample.end()
+                              , threads * kShardsPerThread);
+    double shardedRate = run(threads, keys, [&](long key) {
+      sharded.insert(key);
+    });
+    std::cout << "sharded_btree<long>," << threads << "," << shardedRate
+              << std::endl;
+  }
+
+  return 0;
+}
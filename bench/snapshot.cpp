@@ -0,0 +1,76 @@
+/**
+ * What a snapshot costs a writer on a btree<long> of a million keys:
+ * taking one, against building a full copy of the tree, and the inserts
+ * per second of batches that each start with a fresh snapshot, against
+ * the same batches with none. The first writes after a snapshot copy the
+ * nodes on their way down, so small batches pay for more of them.
+ **/
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "btree.h"
+
+namespace {
+
+const size_t kElems = 1000000;
+const size_t kInserts = 1000000;
+
+template <typename Run>
+double seconds(Run run) {
+  auto start = std::chrono::steady_clock::now();
+  run();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double>(elapsed).count();
+}
+
+}  // namespace close
+
+int main(void) {
+  std::mt19937_64 rng(6771);
+  std::vector<long> elems(kElems);
+  for (long& elem : elems) elem = static_cast<long>(rng() >> 1);
+  std::vector<long> inserts(kInserts);
+  for (long& elem : inserts) elem = static_cast<long>(rng() >> 1);
+  const btree<long> tree(elems.begin(), elems.end());
+
+  std::cout << "operation,batch,value" << std::endl;
+  const size_t kCopies = 1000;
+  double snapshots = seconds([&]() {
+    for (size_t i = 0; i < kCopies; ++i) {
+      const btree<long> copy = tree.snapshot();
+      if (copy.size() != tree.size()) std::cout << "";
+    }
+  });
+  std::cout << "snapshot_us,," << snapshots / kCopies * 1e6 << std::endl;
+  double rebuild = seconds([&]() {
+    const btree<long> copy(tree.begin(), tree.end());
+    if (copy.size() != tree.size()) std::cout << "";
+  });
+  std::cout << "full_copy_us,," << rebuild * 1e6 << std::endl;
+
+  btree<long> plain(elems.begin(), elems.end());
+  double unshared = seconds([&]() {
+    for (long elem : inserts) plain.insert(elem);
+  });
+  std::cout << "inserts_per_s,," << kInserts / unshared << std::endl;
+
+  for (size_t batch : {10, 100, 1000, 10000}) {
+    btree<long> written(elems.begin(), elems.end());
+    double shared = seconds([&]() {
+      for (size_t from = 0; from < kInserts; from += batch) {
+        const btree<long> readers = written.snapshot();
+        for (size_t i = from; i < from + batch && i < kInserts; ++i) {
+          written.insert(inserts[i]);
+        }
+      }
+    });
+    std::cout << "inserts_per_s_with_snapshots," << batch << ","
+              << kInserts / shared << std::endl;
+  }
+
+  return 0;
+}
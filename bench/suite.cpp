@@ -0,0 +1,439 @@
+/**
+ * The benchmark suite behind make bench: btree side by side with
+ * std::set and a sorted std::vector, for long and std::string keys, at
+ * sizes from a thousand to ten million elements, and for btree at
+ * several node sizes. For each it times
+ *
+ *   insert_random, insert_sorted, insert_reverse  inserting every key
+ *       one at a time into an empty container, in that order
+ *   find_hit, find_miss  looking up a million keys that are there, or
+ *       as many that aren't (fewer for small sizes)
+ *   iterate  walking every element in order
+ *   copy  copy-constructing the container; btree copies share their
+ *       nodes, so this is O(1) for it and O(n) for the others
+ *   bulk_load  building the container from the sorted keys in one go
+ *
+ * and writes one row per container, key type, size, node size and
+ * operation, as CSV or, with --json, as a JSON array of objects:
+ *
+ *   ns_per_op      the mean time an operation took, per key or element
+ *   allocs_per_op  calls to operator new per key or element
+ *   peak_rss_kb    the process's peak resident set while the operation
+ *                  ran, where Linux lets it be reset; the peak so far
+ *                  otherwise
+ *
+ * Small sizes are repeated until about a million operations, or a fifth
+ * of a second, have been timed. A sorted vector is only given
+ * one-at-a-time random and reverse inserts up to kVectorInsertLimit
+ * keys, as each of them moves half the vector on average.
+ *
+ * Options: --json, --max-size N (default 10000000), and --nodes a,b,...
+ * for the btree node sizes (default 8,40,128).
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <malloc.h>
+#include <sys/resource.h>
+
+#include "btree.h"
+
+namespace {
+
+const size_t kMinOps = 1000000;
+const double kMinNs = 2e8;
+const size_t kMaxProbes = 1000000;
+const size_t kVectorInsertLimit = 100000;
+
+size_t allocations = 0;
+volatile size_t sink = 0;
+
+struct Options {
+  size_t maxSize = 10000000;
+  std::vector<size_t> nodes = {8, 40, 128};
+  bool json = false;
+};
+
+/**
+ * Starts a fresh peak resident set for the next operation: hands freed
+ * memory back to the system, then asks Linux to reset the high water
+ * mark. Returns false where it can't be reset.
+ **/
+bool resetPeakRss() {
+  malloc_trim(0);
+  std::ofstream clear("/proc/self/clear_refs");
+  clear << "5";
+  clear.close();
+  return static_cast<bool>(clear);
+}
+
+size_t peakRssKb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return std::strtoul(line.c_str() + 6, nullptr, 10);
+    }
+  }
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/**
+ * Writes the rows out as they come, as CSV or as one JSON array.
+ **/
+class Report {
+public:
+  explicit Report(bool json) : json_{json}, rows_{0} {
+    if (json_) {
+      std::cout << "[" << std::endl;
+    } else {
+      std::cout << "container,key,size,node_elems,op,ns_per_op,"
+                << "allocs_per_op,peak_rss_kb" << std::endl;
+    }
+  }
+
+  ~Report() {
+    if (json_) {
+      std::cout << std::endl << "]" << std::endl;
+    }
+  }
+
+  void row(const std::string& container, const std::string& key
+         , size_t size, size_t nodeElems, const std::string& op
+         , double nsPerOp, double allocsPerOp, size_t peakRssKb) {
+    if (json_) {
+      std::cout << (rows_ > 0 ? ",\n" : "") << "  {\"container\": \""
+                << container << "\", \"key\": \"" << key << "\", \"size\": "
+                << size << ", \"node_elems\": " << nodeElems
+                << ", \"op\": \"" << op << "\", \"ns_per_op\": " << nsPerOp
+                << ", \"allocs_per_op\": " << allocsPerOp
+                << ", \"peak_rss_kb\": " << peakRssKb << "}";
+    } else {
+      std::cout << container << "," << key << "," << size << ","
+                << nodeElems << "," << op << "," << nsPerOp << ","
+                << allocsPerOp << "," << peakRssKb << std::endl;
+    }
+    ++rows_;
+  }
+
+private:
+  bool json_;
+  size_t rows_;
+};
+
+/**
+ * The keys of one run: distinct values in random order and sorted, and
+ * probes that are among them and that aren't. Keys come from even
+ * numbers and misses from odd ones, so the two never meet.
+ **/
+template <typename K>
+struct Data {
+  std::vector<K> random;
+  std::vector<K> sorted;
+  std::vector<K> hits;
+  std::vector<K> misses;
+};
+
+template <typename K>
+K keyOf(uint64_t value);
+
+template <>
+long keyOf<long>(uint64_t value) {
+  return static_cast<long>(value);
+}
+
+/**
+ * Spells value in letters, least significant first, so strings made of
+ * distinct values are distinct and of varied length.
+ **/
+template <>
+std::string keyOf<std::string>(uint64_t value) {
+  std::string key;
+  do {
+    key.push_back(static_cast<char>('a' + value % 26));
+    value /= 26;
+  } while (value > 0);
+  return key;
+}
+
+size_t touch(long elem) {
+  return static_cast<size_t>(elem);
+}
+
+size_t touch(const std::string& elem) {
+  return elem.size();
+}
+
+template <typename K>
+Data<K> makeData(size_t size, std::mt19937_64& rng) {
+  std::vector<uint64_t> values(size);
+  for (uint64_t& value : values) value = (rng() >> 24) * 2;
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  std::shuffle(values.begin(), values.end(), rng);
+
+  Data<K> data;
+  data.random.reserve(values.size());
+  for (uint64_t value : values) data.random.push_back(keyOf<K>(value));
+  data.sorted = data.random;
+  std::sort(data.sorted.begin(), data.sorted.end());
+  size_t probes = std::min(values.size(), kMaxProbes);
+  for (size_t i = 0; i < probes; ++i) {
+    uint64_t value = values[rng() % values.size()];
+    data.hits.push_back(keyOf<K>(value));
+    data.misses.push_back(keyOf<K>(value + 1));
+  }
+  return data;
+}
+
+/**
+ * How each container is made, filled and searched.
+ **/
+template <typename K>
+struct SetBench {
+  typedef std::set<K> container;
+  static constexpr const char *name = "std::set";
+
+  static container make(size_t) {
+    return container();
+  }
+
+  template <typename InputIt>
+  static container build(InputIt first, InputIt last, size_t) {
+    return container(first, last);
+  }
+
+  static void insert(container& c, const K& key) {
+    c.insert(key);
+  }
+
+  static bool find(const container& c, const K& key) {
+    return c.find(key) != c.end();
+  }
+};
+
+template <typename K>
+struct VectorBench {
+  typedef std::vector<K> container;
+  static constexpr const char *name = "sorted_vector";
+
+  static container make(size_t) {
+    return container();
+  }
+
+  template <typename InputIt>
+  static container build(InputIt first, InputIt last, size_t) {
+    return container(first, last);
+  }
+
+  static void insert(container& c, const K& key) {
+    auto at = std::lower_bound(c.begin(), c.end(), key);
+    if (at == c.end() || *at != key) {
+      c.insert(at, key);
+    }
+  }
+
+  static bool find(const container& c, const K& key) {
+    return std::binary_search(c.begin(), c.end(), key);
+  }
+};
+
+template <typename K>
+struct BtreeBench {
+  typedef btree<K> container;
+  static constexpr const char *name = "btree";
+
+  static container make(size_t nodeElems) {
+    return container(nodeElems);
+  }
+
+  template <typename InputIt>
+  static container build(InputIt first, InputIt last, size_t nodeElems) {
+    return container(first, last, nodeElems);
+  }
+
+  static void insert(container& c, const K& key) {
+    c.insert(key);
+  }
+
+  static bool find(const container& c, const K& key) {
+    return c.find(key) != c.end();
+  }
+};
+
+/**
+ * Times run(prepare()) over enough repetitions of ops operations each to
+ * add up to about kMinOps of them, or kMinNs, and reports the mean per
+ * operation.
+ * What prepare makes and what run returns are dropped outside the timed
+ * part, so setting up and tearing down containers isn't counted.
+ **/
+template <typename Prepare, typename Run>
+void measure(Report& report, const std::string& container
+           , const std::string& key, size_t size, size_t nodeElems
+           , const std::string& op, size_t ops, Prepare prepare, Run run) {
+  ops = std::max<size_t>(ops, 1);
+  size_t reps = 0;
+  double ns = 0;
+  size_t allocated = 0;
+  resetPeakRss();
+  for (; reps == 0 || (reps * ops < kMinOps && ns < kMinNs); ++reps) {
+    auto state = prepare();
+    size_t allocationsBefore = allocations;
+    auto start = std::chrono::steady_clock::now();
+    auto result = run(state);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    allocated += allocations - allocationsBefore;
+    ns += std::chrono::duration<double, std::nano>(elapsed).count();
+    sink = sink + sizeof(result);
+  }
+  double total = static_cast<double>(reps) * ops;
+  report.row(container, key, size, nodeElems, op, ns / total
+           , allocated / total, peakRssKb());
+}
+
+template <typename Bench, typename K>
+void runContainer(Report& report, const std::string& key, size_t size
+                , size_t nodeElems, const Data<K>& data) {
+  typedef typename Bench::container Container;
+  std::string name = Bench::name;
+  size_t count = data.sorted.size();
+  bool slowInserts = std::is_same<Bench, VectorBench<K>>::value
+                  && count > kVectorInsertLimit;
+
+  auto inserts = [&](const std::string& op, auto first, auto last) {
+    measure(report, name, key, size, nodeElems, op, count
+          , [&]() { return Bench::make(nodeElems); }
+          , [&](Container& c) {
+      for (auto next = first; next != last; ++next) {
+        Bench::insert(c, *next);
+      }
+      return c.size();
+    });
+  };
+  if (!slowInserts) {
+    inserts("insert_random", data.random.begin(), data.random.end());
+  }
+  inserts("insert_sorted", data.sorted.begin(), data.sorted.end());
+  if (!slowInserts) {
+    inserts("insert_reverse", data.sorted.rbegin(), data.sorted.rend());
+  }
+
+  const Container built = Bench::build(data.sorted.begin(), data.sorted.end()
+                                     , nodeElems);
+  auto shared = [&]() { return &built; };
+  auto finds = [&](const std::string& op, const std::vector<K>& probes) {
+    measure(report, name, key, size, nodeElems, op, probes.size(), shared
+          , [&](const Container *c) {
+      size_t found = 0;
+      for (const K& probe : probes) {
+        found += Bench::find(*c, probe);
+      }
+      sink = sink + found;
+      return found;
+    });
+  };
+  finds("find_hit", data.hits);
+  finds("find_miss", data.misses);
+
+  measure(report, name, key, size, nodeElems, "iterate", count, shared
+        , [&](const Container *c) {
+    size_t seen = 0;
+    for (const K& elem : *c) {
+      seen += touch(elem);
+    }
+    sink = sink + seen;
+    return seen;
+  });
+  measure(report, name, key, size, nodeElems, "copy", count, shared
+        , [&](const Container *c) {
+    return Container(*c);
+  });
+  measure(report, name, key, size, nodeElems, "bulk_load", count
+        , []() { return 0; }
+        , [&](int) {
+    return Bench::build(data.sorted.begin(), data.sorted.end(), nodeElems);
+  });
+}
+
+template <typename K>
+void runKey(Report& report, const std::string& key, const Options& options
+          , std::mt19937_64& rng) {
+  for (size_t size = 1000; size <= options.maxSize; size *= 10) {
+    Data<K> data = makeData<K>(size, rng);
+    runContainer<SetBench<K>>(report, key, size, 0, data);
+    runContainer<VectorBench<K>>(report, key, size, 0, data);
+    for (size_t nodeElems : options.nodes) {
+      runContainer<BtreeBench<K>>(report, key, size, nodeElems, data);
+    }
+  }
+}
+
+bool parseOptions(int argc, char *argv[], Options& options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--json") {
+      options.json = true;
+    } else if (arg == "--max-size" && i + 1 < argc) {
+      options.maxSize = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--nodes" && i + 1 < argc) {
+      options.nodes.clear();
+      std::stringstream list(argv[++i]);
+      std::string item;
+      while (std::getline(list, item, ',')) {
+        options.nodes.push_back(std::strtoul(item.c_str(), nullptr, 10));
+      }
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace close
+
+void* operator new(size_t bytes) {
+  ++allocations;
+  if (void *block = std::malloc(bytes == 0 ? 1 : bytes)) {
+    return block;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *block) noexcept {
+  std::free(block);
+}
+
+void operator delete(void *block, size_t) noexcept {
+  std::free(block);
+}
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    std::cerr << "usage: " << argv[0]
+              << " [--json] [--max-size N] [--nodes a,b,...]" << std::endl;
+    return 1;
+  }
+  std::mt19937_64 rng(6771);
+  Report report(options.json);
+  runKey<long>(report, "long", options, rng);
+  runKey<std::string>(report, "string", options, rng);
+  return 0;
+}
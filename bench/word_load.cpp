@@ -0,0 +1,102 @@
+/**
+ * Loading a large word list, one word a line: getline into a string per
+ * word inserted into a btree<std::string>, the same lines bulk loaded
+ * into a btree<std::string>, and word_btree::load. Then a lookup of every
+ * word in each. The list is a few million random lowercase words, written
+ * out in sorted order like twl.txt: once short enough for std::string to
+ * keep them inside the node, once too long for that.
+ **/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+#include "word_btree.h"
+
+namespace {
+
+const size_t kWords = 3000000;
+const char kPath[] = "bench_word_load.txt";
+
+template <typename Run>
+double seconds(Run run) {
+  auto start = std::chrono::steady_clock::now();
+  run();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double>(elapsed).count();
+}
+
+template <typename Tree>
+size_t lookups(const Tree& tree, const std::vector<std::string>& words) {
+  size_t found = 0;
+  for (const std::string& word : words) found += tree.find(word) != tree.end();
+  return found;
+}
+
+/**
+ * Writes out kWords random words of minLength to maxLength letters, and
+ * times each loader on them.
+ **/
+void run(std::mt19937_64& rng, size_t minLength, size_t maxLength) {
+  std::vector<std::string> words(kWords);
+  for (std::string& word : words) {
+    word.resize(minLength + rng() % (maxLength - minLength + 1));
+    for (char& c : word) c = static_cast<char>('a' + rng() % 26);
+  }
+  {
+    btree<std::string> sorted(words.begin(), words.end());
+    std::ofstream out(kPath);
+    for (const std::string& word : sorted) out << word << '\n';
+  }
+  std::string lengths = std::to_string(minLength) + "-"
+                      + std::to_string(maxLength);
+
+  {
+    btree<std::string> tree;
+    double load = seconds([&]() {
+      std::ifstream in(kPath);
+      std::string word;
+      while (std::getline(in, word)) tree.insert(word);
+    });
+    double lookup = seconds([&]() { lookups(tree, words); });
+    std::cout << "getline+insert," << lengths << "," << load << ","
+              << lookup << "," << tree.size() << std::endl;
+  }
+  {
+    btree<std::string> tree;
+    double load = seconds([&]() {
+      std::ifstream in(kPath);
+      std::vector<std::string> lines;
+      std::string word;
+      while (std::getline(in, word)) lines.push_back(word);
+      tree.bulk_load(lines.begin(), lines.end());
+    });
+    double lookup = seconds([&]() { lookups(tree, words); });
+    std::cout << "getline+bulk_load," << lengths << "," << load << ","
+              << lookup << "," << tree.size() << std::endl;
+  }
+  {
+    word_btree<> tree;
+    double load = seconds([&]() { tree.load(kPath); });
+    double lookup = seconds([&]() { lookups(tree, words); });
+    std::cout << "word_btree::load," << lengths << "," << load << ","
+              << lookup << "," << tree.size() << std::endl;
+  }
+  std::remove(kPath);
+}
+
+}  // namespace close
+
+int main(void) {
+  std::mt19937_64 rng(6771);
+  std::cout << "loader,lengths,load_s,lookup_s,words" << std::endl;
+  run(rng, 3, 12);
+  run(rng, 16, 40);
+  return 0;
+}
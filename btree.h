@@ -10,47 +10,170 @@
 #ifndef BTREE_H
 #define BTREE_H
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <cstddef>
+#include <iterator>
+#include <type_traits>
 #include <utility>
 #include <memory>
+#include <new>
 #include <vector>
 #include <queue>
 
 // we better include the iterator
 #include "btree_iterator.h"
+#include "btree_allocator.h"
+#include "btree_search.h"
+#include "btree_compare.h"
+#include "btree_file.h"
+#include "btree_policy.h"
+#include "btree_stats.h"
+#include "btree_thread_pool.h"
+#include "frozen_btree.h"
 
 // we do this to avoid compiler errors about non-template friends
 // what do we do, remember? :)
-template <typename> class btree;
+template <typename, typename, typename, typename> class btree;
 
+template <typename T, typename Compare, typename Allocator, typename Policy>
+std::ostream& operator<< (std::ostream& os
+                        , const btree<T, Compare, Allocator, Policy>& tree);
+
+/**
+ * A node is a single block: a small header followed by a contiguous
+ * array of up to capacity keys and, for internal nodes only,
+ * capacity + 1 child pointers. Keys [0, size) are constructed, the rest
+ * of the array is raw storage. Child i holds the elements between keys
+ * i - 1 and i. Internal nodes of a counted tree follow the pointers with
+ * capacity + 1 subtree counts, count i being the number of elements
+ * under child i; the node moves them together with the children, but
+ * the tree fills them in.
+ *
+ * Nodes don't allocate themselves: the tree asks for
+ * bytes(capacity, leaf, counted) from its allocator and constructs the
+ * node in that block, so the layout is the same whatever the allocator.
+ *
+ * A node can be shared between trees that were copied from one another.
+ * The header counts its owners: the parents pointing at it, or the trees
+ * it is the root of. The count is atomic, as copies may be dropped on
+ * different threads.
+ */
 template <typename T>
-std::ostream& operator<< (std::ostream& os, const btree<T>& tree);
+class btree_node {
+    template <typename, typename, typename, typename> friend class btree;
+public:
+    static size_t bytes(size_t capacity, bool leaf, bool counted);
+    
+    bool isEmpty() const;
+    bool isLeaf() const;
+    bool isCounted() const;
+    bool isShared() const;
+    void addOwner();
+    bool dropOwner();
+    size_t size() const;
+    size_t capacity() const;
+    T* keys() const;
+    btree_node** children() const;
+    size_t* counts() const;
+    T& value(size_t i);
+    btree_node* child(size_t i) const;
+    template <typename V>
+    void addElement(size_t slot, V&& elem, btree_node *rightChild);
+    template <typename It, typename Compare>
+    size_t absorb(It& first, It last, const Compare& comp);
+    void moveTail(size_t from, btree_node& dest);
+    void popBack();
+    template <typename V>
+    void pushFront(V&& elem, btree_node *leftChild);
+    void popFront();
+    void removeKeys(size_t from, size_t to);
+    
+private:
+    btree_node(size_t capacity, bool leaf, bool counted);
+    btree_node(const btree_node&) = delete;
+    btree_node& operator=(const btree_node&) = delete;
+    ~btree_node();
+    
+    static size_t keysOffset();
+    static size_t childrenOffset(size_t capacity);
+    static size_t countsOffset(size_t capacity);
+    void moveChildren(size_t from, size_t to, btree_node& dest, size_t at);
+    
+    unsigned int size_;
+    unsigned int capacity_;
+    bool leaf_;
+    bool counted_;
+    std::atomic<unsigned int> owners_;
+};
+
+/**
+ * The node capacity Policy fixes at compile time for keys of type T, see
+ * btree_policy.h, or 0 if it leaves it to run time.
+ */
+template <typename T, typename Policy>
+constexpr size_t btree_fixed_node_elems() {
+    if (Policy::node_elems > 0) {
+        return Policy::node_elems;
+    }
+    if (Policy::node_bytes == 0) {
+        return 0;
+    }
+    size_t header = (sizeof(btree_node<T>) + alignof(T) - 1) 
+                  / alignof(T) * alignof(T);
+    size_t room = Policy::node_bytes > header ? Policy::node_bytes - header : 0;
+    return std::max<size_t>(2, room / sizeof(T));
+}
   
-template <typename T> 
+template <typename T, typename Compare = std::less<T>
+        , typename Allocator = std::allocator<T>
+        , typename Policy = btree_default_policy>
 class btree {
 public:
   /** Hmm, need some iterator typedefs here... friends? **/
   
-  friend class btree_iterator<T>;
-  friend class const_btree_iterator<T>;
-  
   typedef btree_iterator<T> iterator;
   typedef const_btree_iterator<T> const_iterator;
+  typedef Compare key_compare;
+  typedef Allocator allocator_type;
   /**
    * Constructs an empty btree.  Note that
    * the elements stored in your btree must
    * have a well-defined zero-arg constructor,
    * copy constructor, operator=, and destructor.
-   * The elements must also know how to order themselves
-   * relative to each other by implementing operator<
-   * and operator==. (These are already implemented on
-   * behalf of all built-ins: ints, doubles, strings, etc.)
+   * The elements are ordered by comp, which defaults to their
+   * operator<; two elements neither of which orders before the
+   * other are the same element. See btree_compare.h for comparators
+   * with a three-way comparison, and btree_policy.h for the optional
+   * node features the last template parameter switches on.
    * 
    * @param maxNodeElems the maximum number of elements
+   *        that can be stored in each B-Tree node (at least 2, so a
+   *        full node can always be split around its median); ignored
+   *        when the Policy fixes the node capacity at compile time
+   * @param comp the strict weak ordering of the elements
+   * @param alloc the allocator every node block is obtained from, see
+   *        btree_pool_allocator for one that carves nodes out of slabs
+   */
+  btree(size_t maxNodeElems = 40, const Compare& comp = Compare()
+      , const Allocator& alloc = Allocator());
+  btree(size_t maxNodeElems, const Allocator& alloc);
+
+  /**
+   * Constructs a btree holding the elements of [first, last), built
+   * bottom-up with bulk_load rather than by repeated insertion.
+   *
+   * @param first, last the range of elements to load, in any order
+   * @param maxNodeElems the maximum number of elements
    *        that can be stored in each B-Tree node
+   * @param comp the strict weak ordering of the elements
+   * @param alloc the allocator every node block is obtained from
    */
-  btree(size_t maxNodeElems = 40);
+  template <typename InputIt
+          , typename = typename std::iterator_traits<InputIt>::iterator_category>
+  btree(InputIt first, InputIt last, size_t maxNodeElems = 40
+      , const Compare& comp = Compare(), const Allocator& alloc = Allocator());
 
   /**
    * The copy constructor and  assignment operator.
@@ -65,35 +188,50 @@ public:
    * Copy constructor
    * Creates a new B-Tree as a copy of original.
    *
+   * The copy takes O(1): the two trees share every node, and whichever
+   * of them is changed first copies the nodes on the way down to the
+   * change, leaving the other one's nodes as they were. Iterators only
+   * give const access to the elements, so none can be changed in place.
+   * Only allocators that compare equal to their copy can free each
+   * other's nodes; with any other (btree_pool_allocator gives a copy a
+   * pool of its own) every node is copied up front, as before.
+   *
    * @param original a const lvalue reference to a B-Tree object
    */
-  btree(const btree<T>& original);
+  btree(const btree<T, Compare, Allocator, Policy>& original);
 
   /** 
    * Move constructor
    * Creates a new B-Tree by "stealing" from original.
+   * Takes O(1): the nodes change hands, none are copied or touched, and
+   * original is left empty but usable.
    *
    * @param original an rvalue reference to a B-Tree object
    */
-  btree(btree<T>&& original);
+  btree(btree<T, Compare, Allocator, Policy>&& original);
   
   
   /** 
    * Copy assignment
-   * Replaces the contents of this object with a copy of rhs.
+   * Replaces the contents of this object with a copy of rhs, made as the
+   * copy constructor makes it. The allocator, ordering and node size are
+   * taken from rhs along with its elements.
    *
    * @param rhs a const lvalue reference to a B-Tree object
    */
-  btree<T>& operator=(const btree<T>& rhs);
+  btree<T, Compare, Allocator, Policy>& operator=(
+          const btree<T, Compare, Allocator, Policy>& rhs);
 
   /** 
    * Move assignment
    * Replaces the contents of this object with the "stolen"
-   * contents of original.
+   * contents of original, in O(1) beyond freeing what this object held.
+   * rhs is left empty but usable.
    *
    * @param rhs a const reference to a B-Tree object
    */
-  btree<T>& operator=(btree<T>&& rhs);
+  btree<T, Compare, Allocator, Policy>& operator=(
+          btree<T, Compare, Allocator, Policy>&& rhs);
 
   /**
    * Puts a breadth-first traversal of the B-Tree onto the output
@@ -104,7 +242,8 @@ public:
    * @param tree a const reference to a B-Tree object
    * @return a reference to os
    */
-  friend std::ostream& operator<< <T> (std::ostream& os, const btree<T>& tree);
+  friend std::ostream& operator<< <T, Compare, Allocator, Policy> (
+          std::ostream& os, const btree<T, Compare, Allocator, Policy>& tree);
   /**
    * The following can go here
    * -- begin() 
@@ -117,27 +256,29 @@ public:
    * -- crend() 
    */
   iterator begin() const {
-    return iterator(*this, "begin");
+    iterator iter(root_);
+    iter.descendLeftmost(root_);
+    return iter;
   }
    
   iterator end() const {
-    return iterator(*this, "end");
+    return iterator(root_);
   }
   
   iterator rbegin() const {
-    return iterator(*this, "end");
+    return end();
   }
    
   iterator rend() const {
-    return iterator(*this, "begin");
+    return begin();
   }
   
   const_iterator cbegin() const {
-    return const_iterator(*this, "begin");
+    return begin();
   }
   
   const_iterator cend() const {
-    return const_iterator(*this, "end");
+    return end();
   }
   
   /**
@@ -145,12 +286,10 @@ public:
     * the non-const end() returns if the element could 
     * not be found.  
     *
-    * @param elem the client element we are trying to match.  The elem,
-    *        if an instance of a true class, relies on the operator< and
-    *        and operator== methods to compare elem to elements already 
-    *        in the btree.  You must ensure that your class implements
-    *        these things, else code making use of btree<T>::find will
-    *        not compile.
+    * @param elem the client element we are trying to match.  The elem
+    *        is compared to elements already in the btree with the
+    *        btree's comparator, once per probe when it offers a
+    *        three-way comparison.
     * @return an iterator to the matching element, or whatever the
     *         non-const end() returns if no such match was ever found.
     */
@@ -166,6 +305,146 @@ public:
     *         const end() returns if no such match was ever found.
     */
   const_iterator find(const T& elem) const;
+
+  /**
+    * Looks up anything the comparator can order against the elements,
+    * without converting it to a T first. Only offered when Compare is
+    * transparent, e.g. std::less<>.
+    *
+    * @param elem the key to match, e.g. a const char* or a
+    *        std::string_view for a btree of std::string
+    * @return an iterator to the matching element, or end()
+    */
+  template <typename K, typename C = Compare
+          , typename = typename C::is_transparent>
+  iterator find(const K& elem);
+
+  template <typename K, typename C = Compare
+          , typename = typename C::is_transparent>
+  const_iterator find(const K& elem) const;
+
+  /**
+    * Returns an iterator to the first element not less than elem, or
+    * end() if there is none. Costs one root-to-leaf descent; moving on
+    * from there walks the tree in order, so reading k elements from the
+    * result costs O(log n + k).
+    *
+    * @param elem the bound to search for
+    */
+  iterator lower_bound(const T& elem);
+  const_iterator lower_bound(const T& elem) const;
+
+  template <typename K, typename C = Compare
+          , typename = typename C::is_transparent>
+  iterator lower_bound(const K& elem);
+
+  template <typename K, typename C = Compare
+          , typename = typename C::is_transparent>
+  const_iterator lower_bound(const K& elem) const;
+
+  /**
+    * Returns an iterator to the first element greater than elem, or
+    * end() if there is none, from the same single descent.
+    *
+    * @param elem the bound to search for
+    */
+  iterator upper_bound(const T& elem);
+  const_iterator upper_bound(const T& elem) const;
+
+  template <typename K, typename C = Compare
+          , typename = typename C::is_transparent>
+  iterator upper_bound(const K& elem);
+
+  template <typename K, typename C = Compare
+          , typename = typename C::is_transparent>
+  const_iterator upper_bound(const K& elem) const;
+
+  /**
+    * Returns lower_bound(elem) and upper_bound(elem) as a pair, found
+    * with one descent. Keys are unique, so the range holds at most the
+    * one matching element.
+    *
+    * @param elem the element to search for
+    */
+  std::pair<iterator, iterator> equal_range(const T& elem);
+  std::pair<const_iterator, const_iterator> equal_range(const T& elem) const;
+
+  template <typename K, typename C = Compare
+          , typename = typename C::is_transparent>
+  std::pair<iterator, iterator> equal_range(const K& elem);
+
+  template <typename K, typename C = Compare
+          , typename = typename C::is_transparent>
+  std::pair<const_iterator, const_iterator> equal_range(const K& elem) const;
+
+  /**
+    * A view of the elements in [lo, hi), usable in a range-based for.
+    * Both ends are found up front with one descent each, after which
+    * iterating the view streams across the leaves: O(log n + k) for k
+    * elements in the range. The range is empty if hi is not above lo.
+    *
+    * @param lo the smallest element to include
+    * @param hi the first element past the range
+    */
+  btree_range<iterator> range(const T& lo, const T& hi);
+  btree_range<const_iterator> range(const T& lo, const T& hi) const;
+
+  template <typename K, typename C = Compare
+          , typename = typename C::is_transparent>
+  btree_range<iterator> range(const K& lo, const K& hi);
+
+  template <typename K, typename C = Compare
+          , typename = typename C::is_transparent>
+  btree_range<const_iterator> range(const K& lo, const K& hi) const;
+
+  /**
+    * Looks up every key of [first, last) on the calling thread, writing
+    * the result for first[i] to out[i] as find_many does. Rather than one
+    * after the other, the lookups are run in groups of 16 that go down
+    * the tree in lockstep: each step searches the current node of every
+    * lookup in the group, and asks for the node each one moves on to
+    * to be prefetched. By the time the group comes round to those nodes
+    * they are mostly in cache, so the misses of 16 lookups overlap
+    * instead of being waited out one at a time.
+    *
+    * @param first, last random access iterators to the keys to look up
+    * @param out a random access iterator to room for last - first results
+    */
+  template <typename RandomIt, typename OutputIt>
+  void find_batch(RandomIt first, RandomIt last, OutputIt out) const;
+
+  /**
+    * Looks up every key of [first, last) at once, splitting the keys
+    * between the threads of pool. The result for first[i] goes to out[i]:
+    * a pointer to the matching element, or nullptr if there is none.
+    * The pointers stay valid until the btree is next changed, which it
+    * must not be while the lookups run.
+    *
+    * Each thread runs its share as find_batch does. Lookups keep no path,
+    * so the threads share nothing but the tree they read.
+    *
+    * @param first, last random access iterators to the keys to look up
+    * @param out a random access iterator to room for last - first results
+    * @param pool the threads to spread the lookups over
+    */
+  template <typename RandomIt, typename OutputIt>
+  void find_many(RandomIt first, RandomIt last, OutputIt out
+               , btree_thread_pool& pool = btree_thread_pool::shared()) const;
+
+  /**
+    * Like find_many, writing true to out[i] if first[i] is in the btree
+    * and false otherwise. The results are written from several threads at
+    * once, so out must not pack them into shared words as the iterators
+    * of std::vector<bool> do.
+    */
+  template <typename RandomIt, typename OutputIt>
+  void contains_many(RandomIt first, RandomIt last, OutputIt out
+                   , btree_thread_pool& pool = btree_thread_pool::shared()) const;
+
+  /**
+    * Returns a copy of the ordering the btree was constructed with.
+    */
+  key_compare key_comp() const;
       
   /**
     * Operation which inserts the specified element
@@ -185,8 +464,8 @@ public:
     *
     * The insert method makes use of T's zero-arg constructor and 
     * operator= method, and if these things aren't available, 
-    * then the call to btree<T>::insert will not compile.  The implementation
-    * also makes use of the class's operator== and operator< as well.
+    * then the call to btree<T>::insert will not compile.  Elements are
+    * ordered and matched with the btree's comparator.
     *
     * @param elem the element to be inserted.
     * @return a pair whose first field is an iterator positioned at
@@ -196,6 +475,188 @@ public:
     */
   std::pair<iterator, bool> insert(const T& elem);
 
+  /**
+    * Like insert(const T&), moving elem into its slot rather than copying
+    * it. elem is only moved from if it was inserted; an element that was
+    * already there leaves it as it was. Needed for keys that can only be
+    * moved, such as std::unique_ptr.
+    */
+  std::pair<iterator, bool> insert(T&& elem);
+
+  /**
+    * Inserts an element constructed from args, as insert does. The
+    * element has to exist before it can be compared with the keys, so it
+    * is built once on the stack and moved into its slot from there; it is
+    * never copied.
+    *
+    * @param args the arguments to construct the element from
+    */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args);
+
+  /**
+    * Replaces the contents of the btree with the elements of
+    * [first, last), building it bottom-up in O(n): the leaves are packed
+    * left to right and each internal level is built over the one below,
+    * with no searching and no splitting.
+    *
+    * Sorted input (as checked in one pass over a forward range) is read
+    * straight into the nodes. Anything else is first copied out, sorted
+    * and stripped of duplicates.
+    *
+    * @param first, last the range of elements to load
+    * @param fillFactor the fraction of maxNodeElems each node is filled
+    *        to, clamped to [0.5, 1]. Full nodes make the smallest and
+    *        shallowest tree; leaving room makes later inserts cheaper.
+    */
+  template <typename InputIt>
+  void bulk_load(InputIt first, InputIt last, double fillFactor = 1.0);
+
+  /**
+    * Inserts every element of [first, last) not already in the btree.
+    * The batch is sorted and stripped of duplicates, then merged into
+    * the tree a leaf at a time: one descent finds the leaf for the
+    * smallest outstanding element and every following element that
+    * belongs to the same leaf is merged in while it has room. A leaf
+    * that fills up is split once and the merge carries on in its halves,
+    * so splits are spread across the batch instead of paid per element.
+    *
+    * @param first, last the range of elements to insert, in any order
+    * @return the number of elements that were not in the btree before
+    */
+  template <typename InputIt
+          , typename = typename std::iterator_traits<InputIt>::iterator_category>
+  size_t insert(InputIt first, InputIt last);
+
+  /**
+    * Removes the matching element, if there is one. A node left with
+    * fewer than half of maxNodeElems elements borrows one from a
+    * neighbour that can spare it, or is merged with that neighbour
+    * otherwise; merged away nodes go straight back to the allocator and
+    * the root is dropped once it runs out of elements, so the tree only
+    * ever holds about as many nodes as its elements need.
+    *
+    * Erasing invalidates every iterator into the btree.
+    *
+    * @param elem the element to remove
+    * @return the number of elements removed, 0 or 1
+    */
+  size_t erase(const T& elem);
+
+  /**
+    * Removes the element pos points to, which must not be end().
+    *
+    * @param pos an iterator to the element to remove
+    * @return an iterator to the element that followed it
+    */
+  iterator erase(iterator pos);
+
+  /**
+    * Removes the elements [first, last). Rather than going element by
+    * element, the range is cut out along the two root-to-leaf paths
+    * through its ends: every subtree between the paths is dropped whole,
+    * and the nodes on the paths are then rebalanced as for a single
+    * erase.
+    *
+    * @param first, last the range of elements to remove
+    * @return an iterator to the element last pointed to
+    */
+  iterator erase(iterator first, iterator last);
+
+  /**
+    * Returns the number of levels in the btree, 0 when it is empty.
+    * Nodes are split as they overflow, so all leaves sit at this depth
+    * and it grows logarithmically with the number of elements.
+    */
+  size_t height() const;
+
+  /**
+    * Returns the number of elements in the btree. The count is kept up
+    * to date by every insert and erase, so this is O(1).
+    */
+  size_t size() const;
+
+  /**
+    * Returns true if the btree holds no elements.
+    */
+  bool empty() const;
+
+  /**
+    * Returns the number of elements less than elem, whether or not elem
+    * itself is in the btree, i.e. the position lower_bound(elem) is at.
+    * One descent, adding up the subtree counts of the children passed
+    * over on the way down: O(log n) with O(maxNodeElems) additions per
+    * level. Only available with a counted Policy, see btree_policy.h.
+    *
+    * @param elem the element to rank
+    */
+  size_t rank(const T& elem) const;
+
+  template <typename K, typename C = Compare
+          , typename = typename C::is_transparent>
+  size_t rank(const K& elem) const;
+
+  /**
+    * Returns an iterator to the element with k elements before it, the
+    * k-th smallest counting from 0, or end() if k is not below size().
+    * Like rank, steers by the subtree counts in a single descent and
+    * needs a counted Policy.
+    *
+    * @param k the position of the element wanted
+    */
+  iterator select(size_t k) const;
+
+  /**
+    * Returns a copy of the btree as it is now, for readers that should
+    * see one consistent version however it is changed afterwards. Like
+    * any copy it shares the nodes rather than copying them, so it is
+    * cheap to take whenever the btree has been changed, e.g. after each
+    * batch of writes.
+    *
+    * The snapshot itself must be taken where nothing changes the btree
+    * at the same time. From then on the two are independent: the
+    * snapshot can be read (and dropped) on other threads while this
+    * btree goes on being changed, without locking.
+    */
+  btree<T, Compare, Allocator, Policy> snapshot() const;
+
+  /**
+    * Writes the elements to path in the page format of btree_file.h, for
+    * a mapped_btree to serve lookups from without reading them back in.
+    * The file gets nodes of its own, sized to fill a page, rather than
+    * copies of the btree's. Keys must be trivially copyable, or strings.
+    * A mapped_btree over the file has to order them as Compare does.
+    *
+    * @param path the file to write, replaced whole if it exists
+    * @return true if the file was written
+    */
+  bool save(const std::string& path) const;
+
+  /**
+    * Returns a copy of the elements laid out for a tree that will only be
+    * read from now on, see frozen_btree.h: in order in one array, with
+    * levels of separators above them found by position rather than by
+    * pointer. Takes O(n) and leaves this btree as it is.
+    */
+  frozen_btree<T, Compare> freeze() const;
+
+  /**
+    * Walks every node and reports the shape of the btree: its height,
+    * the nodes on each level, how full they are and the bytes they take,
+    * see btree_stats.h. O(n / maxNodeElems), and available on any tree,
+    * e.g. to pick maxNodeElems or to spot a degenerate shape.
+    */
+  btree_stats stats() const;
+
+  /**
+    * Returns the lookups, node visits, comparisons, splits and node
+    * allocations counted since the btree was made or reset_counters was
+    * last called, see btree_stats.h. Needs an instrumented Policy, see
+    * btree_policy.h; copies start counting from zero.
+    */
+  btree_counters counters() const;
+  void reset_counters();
+
   /**
     * Disposes of all internal resources, which includes
     * the disposal of any client objects previously
@@ -206,50 +667,101 @@ public:
   
 private:
     // The details of your implementation go here
-    class Node;
-    class Node {
-        class Element {
-            friend class btree_iterator<T>;
-            friend class const_btree_iterator<T>;
-        public:
-            Element();
-            Element(T value);
-            ~Element();
-            T getValue() const;
-            std::shared_ptr<Node> getLeftChild() const;
-            std::shared_ptr<Node> getRightChild() const;
-            std::shared_ptr<Node> getParent() const;
-            void setValue(T value);
-            void setLeftChild(std::shared_ptr<Node> sharedPtr);
-            void setRightChild(std::shared_ptr<Node> sharedPtr);
-            void setParent(std::shared_ptr<Node> sharedPtr);
-        private:
-            T value_;
-            std::shared_ptr<Node> leftChild_;
-            std::shared_ptr<Node> rightChild_;
-            
-        };
-        friend class btree;
-        friend class btree_iterator<T>;
-        friend class const_btree_iterator<T>;
-    public:
-        Node();
-        Node(std::nullptr_t);
-        ~Node();
-        bool isEmpty();
-        typename btree<T>::Node::Element* addElement(const T& elem);
-        std::vector<Element> getElements() const;
-        
-    private:
-        std::vector<Element> elems_;
-        
-    };
+    typedef btree_node<T> Node;
+    typedef typename iterator::Path Path;
     
-    void copyTree(Node& copy, Node& original);
+    // node blocks are handed out in units that are aligned for any key
+    typedef typename std::allocator_traits<Allocator>::template 
+            rebind_alloc<std::max_align_t> NodeAllocator;
     
-    std::shared_ptr<Node> root_;
+    static constexpr size_t kNodeElems = btree_fixed_node_elems<T, Policy>();
+    
+    size_t nodeElems() const;
+    static Node* childOf(const Node *node, size_t i);
+    static size_t nodeUnits(size_t capacity, bool leaf);
+    Node* createNode(bool leaf);
+    void destroyNode(Node *node);
+    
+    template <typename K>
+    size_t lowerBound(const Node *node, const K& elem) const;
+    template <typename K>
+    size_t search(const Node *node, const K& elem, bool& found) const;
+    template <typename K>
+    bool locate(const K& elem, Path& path) const;
+    template <typename RandomIt, typename Found>
+    void lookupGroups(RandomIt first, size_t count, Found found) const;
+    const T* upperFence(const Path& path) const;
+    template <typename V>
+    std::pair<iterator, bool> insertValue(V&& elem);
+    template <typename V>
+    T splitInsert(Node *node, size_t slot, V&& elem
+                , Node *rightChild, Node *&sibling, const T *&placed);
+    template <typename InputIt>
+    void bulkLoad(InputIt first, InputIt last, double fillFactor
+                , std::input_iterator_tag);
+    template <typename ForwardIt>
+    void bulkLoad(ForwardIt first, ForwardIt last, double fillFactor
+                , std::forward_iterator_tag);
+    template <typename ForwardIt>
+    void buildSorted(ForwardIt first, size_t count, double fillFactor);
+    template <typename K>
+    Path seek(const K& elem, bool& found) const;
+    template <typename Iterator>
+    btree_range<Iterator> orderedRange(Iterator first, Iterator last) const;
+    template <typename K>
+    size_t countBelow(const K& elem) const;
+    static size_t subtreeSize(const Node *node);
+    void recount(Node *node, size_t i);
+    void recountChildren(Node *node);
+    void countAlong(const Path& path, size_t depth, std::ptrdiff_t delta);
+    size_t minNodeElems() const;
+    void eraseAt(Path& path);
+    size_t eraseRange(Node *node, const T *lo, const T *hi);
+    T extractFirst(Node *node);
+    T extractLast(Node *node);
+    static bool isHollow(const Node *node);
+    void rebalance(const Path& path);
+    void fixChild(Node *parent, size_t i);
+    void fixChildren(Node *node);
+    void borrowFromLeft(Node *parent, size_t i);
+    void borrowFromRight(Node *parent, size_t i);
+    void mergeChildren(Node *parent, size_t i);
+    void shrinkRoot();
+    void dropAll();
+    Node* own(Node *&slot);
+    Node* ownChild(Node *parent, size_t i);
+    void ownPath(Path& path);
+    Node* copyTree(const Node *original);
+    static size_t treeSize(const Node *node);
+    size_t destroyTree(Node *node);
+    void dropTree(Node *node);
+    void destroyKeys(Node *node);
+    void collectStats(const Node *node, size_t depth, btree_stats& stats) const;
+    
+    template <typename A>
+    auto releaseAll(A& alloc, int) -> decltype(alloc.release(), bool());
+    template <typename A>
+    bool releaseAll(A& alloc, long);
+    
+    Node *root_;
+    size_t size_;
     size_t maxNodeElems_;
+    Compare comp_;
+    NodeAllocator alloc_;
+    
+    // counted into from const lookups too, and empty unless instrumented
+    typedef std::conditional_t<Policy::instrumented, btree_counter_cells
+                             , btree_no_counters> Counters;
+    mutable Counters counters_;
 };
 
+/**
+ * A btree whose node capacity N is fixed at compile time, see
+ * btree_fixed_policy.
+ */
+template <typename T, size_t N, typename Compare = std::less<T>
+        , typename Allocator = std::allocator<T>>
+using fixed_btree = btree<T, Compare, Allocator, btree_fixed_policy<N>>;
+
 #include "btree.tem"
 #endif
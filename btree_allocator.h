@@ -0,0 +1,243 @@
+#ifndef BTREE_ALLOCATOR_H
+#define BTREE_ALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+/**
+ * A pool of fixed-size blocks for B-Tree nodes. A tree only ever asks for
+ * two block sizes (leaves and internal nodes), so each size gets its own
+ * free list and is carved out of large slabs. Freed blocks go back on
+ * their free list for the next node of the same size; release() hands
+ * every slab back at once, whatever was still allocated from them.
+ */
+class btree_node_pool {
+public:
+    explicit btree_node_pool(size_t slabBytes = 64 * 1024);
+    ~btree_node_pool();
+
+    btree_node_pool(const btree_node_pool&) = delete;
+    btree_node_pool& operator=(const btree_node_pool&) = delete;
+
+    void* allocate(size_t bytes);
+    void deallocate(void *block, size_t bytes);
+    void release();
+
+    size_t slabBytes() const;
+    size_t slabCount() const;
+    size_t bytesInUse() const;
+
+private:
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    struct SizeClass {
+        size_t blockBytes;
+        FreeBlock *freeList;
+        char *cursor;
+        char *end;
+    };
+
+    static size_t roundUp(size_t bytes);
+    SizeClass& sizeClass(size_t blockBytes);
+
+    std::vector<SizeClass> classes_;
+    std::vector<void*> slabs_;
+    size_t slabBytes_;
+    size_t bytesInUse_;
+};
+
+/**
+ * A standard allocator drawing from a shared btree_node_pool, for use as
+ * btree<T, std::less<T>, btree_pool_allocator<T>>. A default constructed
+ * allocator gets a pool of its own; copies and rebinds share it. A tree
+ * copied from another gets a fresh pool, so each tree can drop all of its
+ * nodes in one go when it is destroyed.
+ */
+template <typename T>
+class btree_pool_allocator {
+    template <typename> friend class btree_pool_allocator;
+public:
+    typedef T value_type;
+
+    btree_pool_allocator();
+    explicit btree_pool_allocator(std::shared_ptr<btree_node_pool> pool);
+    template <typename U>
+    btree_pool_allocator(const btree_pool_allocator<U>& other);
+
+    T* allocate(size_t n);
+    void deallocate(T *p, size_t n);
+
+    btree_pool_allocator select_on_container_copy_construction() const;
+
+    /**
+     * True when nothing else draws from this allocator's pool, in which
+     * case release() may drop all of it without stranding anyone.
+     */
+    bool exclusive() const;
+    void release();
+
+    std::shared_ptr<btree_node_pool> pool() const;
+
+    template <typename U>
+    bool operator==(const btree_pool_allocator<U>& other) const;
+    template <typename U>
+    bool operator!=(const btree_pool_allocator<U>& other) const;
+
+private:
+    std::shared_ptr<btree_node_pool> pool_;
+};
+
+// btree_node_pool
+inline btree_node_pool::btree_node_pool(size_t slabBytes)
+    : classes_{}
+    , slabs_{}
+    , slabBytes_{slabBytes}
+    , bytesInUse_{0} {
+}
+
+inline btree_node_pool::~btree_node_pool() {
+    release();
+}
+
+inline size_t btree_node_pool::roundUp(size_t bytes) {
+    size_t align = alignof(std::max_align_t);
+    size_t rounded = (bytes + align - 1) / align * align;
+    return rounded < sizeof(FreeBlock) ? sizeof(FreeBlock) : rounded;
+}
+
+inline btree_node_pool::SizeClass& btree_node_pool::sizeClass(size_t blockBytes) {
+    for (auto& sizeClass : classes_) {
+        if (sizeClass.blockBytes == blockBytes) {
+            return sizeClass;
+        }
+    }
+    classes_.push_back(SizeClass{blockBytes, nullptr, nullptr, nullptr});
+    return classes_.back();
+}
+
+inline void* btree_node_pool::allocate(size_t bytes) {
+    SizeClass& sizeClass = this->sizeClass(roundUp(bytes));
+    bytesInUse_ += sizeClass.blockBytes;
+
+    if (sizeClass.freeList != nullptr) {
+        FreeBlock *block = sizeClass.freeList;
+        sizeClass.freeList = block->next;
+        return block;
+    }
+
+    if (sizeClass.cursor == nullptr
+            || static_cast<size_t>(sizeClass.end - sizeClass.cursor)
+                < sizeClass.blockBytes) {
+        size_t slab = slabBytes_ < sizeClass.blockBytes
+                        ? sizeClass.blockBytes : slabBytes_;
+        slabs_.reserve(slabs_.size() + 1);
+        char *mem = static_cast<char*>(::operator new(slab));
+        slabs_.push_back(mem);
+        sizeClass.cursor = mem;
+        sizeClass.end = mem + slab / sizeClass.blockBytes * sizeClass.blockBytes;
+    }
+
+    void *block = sizeClass.cursor;
+    sizeClass.cursor += sizeClass.blockBytes;
+    return block;
+}
+
+inline void btree_node_pool::deallocate(void *block, size_t bytes) {
+    SizeClass& sizeClass = this->sizeClass(roundUp(bytes));
+    bytesInUse_ -= sizeClass.blockBytes;
+    FreeBlock *freed = static_cast<FreeBlock*>(block);
+    freed->next = sizeClass.freeList;
+    sizeClass.freeList = freed;
+}
+
+inline void btree_node_pool::release() {
+    for (void *slab : slabs_) {
+        ::operator delete(slab);
+    }
+    slabs_.clear();
+    classes_.clear();
+    bytesInUse_ = 0;
+}
+
+inline size_t btree_node_pool::slabBytes() const {
+    return slabBytes_;
+}
+
+inline size_t btree_node_pool::slabCount() const {
+    return slabs_.size();
+}
+
+inline size_t btree_node_pool::bytesInUse() const {
+    return bytesInUse_;
+}
+
+// btree_pool_allocator
+template <typename T>
+btree_pool_allocator<T>::btree_pool_allocator()
+    : pool_{std::make_shared<btree_node_pool>()} {
+}
+
+template <typename T>
+btree_pool_allocator<T>::btree_pool_allocator(
+        std::shared_ptr<btree_node_pool> pool)
+    : pool_{std::move(pool)} {
+}
+
+template <typename T>
+template <typename U>
+btree_pool_allocator<T>::btree_pool_allocator(
+        const btree_pool_allocator<U>& other)
+    : pool_{other.pool_} {
+}
+
+template <typename T>
+T* btree_pool_allocator<T>::allocate(size_t n) {
+    return static_cast<T*>(pool_->allocate(n * sizeof(T)));
+}
+
+template <typename T>
+void btree_pool_allocator<T>::deallocate(T *p, size_t n) {
+    pool_->deallocate(p, n * sizeof(T));
+}
+
+template <typename T>
+btree_pool_allocator<T>
+btree_pool_allocator<T>::select_on_container_copy_construction() const {
+    return btree_pool_allocator<T>(
+            std::make_shared<btree_node_pool>(pool_->slabBytes()));
+}
+
+template <typename T>
+bool btree_pool_allocator<T>::exclusive() const {
+    return pool_.use_count() == 1;
+}
+
+template <typename T>
+void btree_pool_allocator<T>::release() {
+    pool_->release();
+}
+
+template <typename T>
+std::shared_ptr<btree_node_pool> btree_pool_allocator<T>::pool() const {
+    return pool_;
+}
+
+template <typename T>
+template <typename U>
+bool btree_pool_allocator<T>::operator==(
+        const btree_pool_allocator<U>& other) const {
+    return pool_ == other.pool_;
+}
+
+template <typename T>
+template <typename U>
+bool btree_pool_allocator<T>::operator!=(
+        const btree_pool_allocator<U>& other) const {
+    return !operator==(other);
+}
+
+#endif
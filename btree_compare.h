@@ -0,0 +1,87 @@
+#ifndef BTREE_COMPARE_H
+#define BTREE_COMPARE_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/**
+ * How the tree orders its keys. Compare is a strict weak ordering, as for
+ * std::set, and may in addition offer a three-way comparison as a member
+ *
+ *     int compare(const A& lhs, const B& rhs) const;
+ *
+ * returning something less than, equal to or greater than 0. With one,
+ * the search within a node makes a single call per probe and notices a
+ * match on the way down, where a plain ordering needs a second call to
+ * tell a match from the next key up. std::less<T> and std::less<> get
+ * it for free on std::basic_string and std::basic_string_view keys,
+ * whose compare is known to order as their operator< does. Other keys
+ * opt in only through a comparator with a compare member: a key's own
+ * compare member might return a bool, or order some other way.
+ *
+ * A comparator with an is_transparent member type, such as std::less<>,
+ * also lets lookups take anything it can order against the keys, e.g. a
+ * btree<std::string, std::less<>> searched with a const char* or a
+ * std::string_view without building a std::string first.
+ */
+
+template <typename Compare, typename A, typename B, typename = void>
+struct btree_has_member_compare : std::false_type {};
+
+template <typename Compare, typename A, typename B>
+struct btree_has_member_compare<Compare, A, B, std::void_t<decltype(
+        std::declval<const Compare&>().compare(std::declval<const A&>()
+                                             , std::declval<const B&>()))>>
+    : std::true_type {};
+
+template <typename T>
+struct btree_is_string : std::false_type {};
+
+template <typename C, typename Traits, typename Alloc>
+struct btree_is_string<std::basic_string<C, Traits, Alloc>> : std::true_type {};
+
+template <typename C, typename Traits>
+struct btree_is_string<std::basic_string_view<C, Traits>> : std::true_type {};
+
+// a string key's compare, taking another string or a C string
+template <typename A, typename B, typename = void>
+struct btree_has_key_compare : std::false_type {};
+
+template <typename A, typename B>
+struct btree_has_key_compare<A, B, std::void_t<decltype(
+        std::declval<const A&>().compare(std::declval<const B&>()))>>
+    : std::integral_constant<bool, btree_is_string<A>::value
+            && (btree_is_string<B>::value
+                || std::is_pointer<std::decay_t<B>>::value)> {};
+
+template <typename Compare>
+struct btree_is_less : std::false_type {};
+
+template <typename T>
+struct btree_is_less<std::less<T>> : std::true_type {};
+
+/**
+ * True when btree_compare(comp, lhs, rhs) costs a single comparison
+ * rather than two calls to comp.
+ */
+template <typename Compare, typename A, typename B>
+struct btree_three_way : std::integral_constant<bool
+        , btree_has_member_compare<Compare, A, B>::value
+            || (btree_is_less<Compare>::value
+                && btree_has_key_compare<A, B>::value)> {};
+
+template <typename Compare, typename A, typename B>
+int btree_compare(const Compare& comp, const A& lhs, const B& rhs) {
+    if constexpr (btree_has_member_compare<Compare, A, B>::value) {
+        return comp.compare(lhs, rhs);
+    } else if constexpr (btree_three_way<Compare, A, B>::value) {
+        return lhs.compare(rhs);
+    } else {
+        return comp(lhs, rhs) ? -1 : comp(rhs, lhs) ? 1 : 0;
+    }
+}
+
+#endif
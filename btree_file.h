@@ -0,0 +1,346 @@
+#ifndef BTREE_FILE_H
+#define BTREE_FILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * The file format btree::save writes and mapped_btree reads in place.
+ *
+ * The file is a run of pages. Page 0 is the header, then come the nodes,
+ * one page each, and after them the key data, if there is any. Nodes
+ * refer to their children by page index, not by address, so the file
+ * means the same wherever it is mapped. Leaves come first, left to
+ * right, then each level above them in turn, the root last.
+ *
+ * A node page starts with two 32-bit words, the number of keys and
+ * whether it is a leaf, followed by its keys from keyOffset, which is
+ * as far in as the keys' alignment needs. Internal nodes hold up to
+ * nodeKeys keys and then nodeKeys + 1 child indices; leaves have no
+ * children and use the rest of the page for up to leafKeys keys.
+ *
+ * Numbers are written in the byte order of the machine that saved the
+ * file. The endian field catches files from a machine of the other
+ * order.
+ */
+const uint32_t kBtreeFileVersion = 2;
+const size_t kBtreeFilePage = 4096;
+const size_t kBtreeFileNodeHeader = 8;
+
+struct btree_file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint32_t keyKind;
+    uint32_t keyBytes;
+    uint32_t keyOffset;
+    uint32_t reserved;
+    uint32_t pageBytes;
+    uint32_t leafKeys;
+    uint32_t nodeKeys;
+    uint32_t height;
+    uint64_t root;
+    uint64_t nodes;
+    uint64_t elems;
+    uint64_t dataOffset;
+    uint64_t dataBytes;
+};
+
+/**
+ * The kinds of key a file can hold, kept in the header with the key's
+ * size so that a file isn't opened as keys of another type of the same
+ * size: a long as a double, or an int64_t as a uint64_t. Other trivially
+ * copyable types, structs and enums, are only told apart by size.
+ */
+const uint32_t kBtreeFileSigned = 1;
+const uint32_t kBtreeFileUnsigned = 2;
+const uint32_t kBtreeFileFloating = 3;
+const uint32_t kBtreeFileOther = 4;
+const uint32_t kBtreeFileString = 5;
+
+template <typename T>
+constexpr uint32_t btree_file_kind() {
+    if (std::is_floating_point<T>::value) {
+        return kBtreeFileFloating;
+    }
+    if (std::is_integral<T>::value) {
+        return std::is_signed<T>::value ? kBtreeFileSigned
+                                        : kBtreeFileUnsigned;
+    }
+    return kBtreeFileOther;
+}
+
+/**
+ * How a key of type T is laid out in a node and handed back from the
+ * mapping. Keys that are trivially copyable are stored as they are and
+ * read back by reference, straight out of the page.
+ */
+template <typename T>
+struct btree_file_key {
+    static_assert(std::is_trivially_copyable<T>::value
+                , "saved keys must be trivially copyable, or std::string");
+
+    typedef T stored;
+    typedef const T& reference;
+    static const uint32_t kind = btree_file_kind<T>();
+
+    static const stored& store(const T& elem, std::string&) {
+        return elem;
+    }
+
+    static reference view(const stored& slot, const char *, size_t) {
+        return slot;
+    }
+
+    static bool fits(const stored&, size_t) {
+        return true;
+    }
+};
+
+/**
+ * Strings are stored as the position and length of their characters in
+ * the data that follows the nodes, and read back as string_views of the
+ * mapping, once checked to lie within the data.
+ */
+template <>
+struct btree_file_key<std::string> {
+    struct stored {
+        uint64_t offset;
+        uint64_t size;
+    };
+    typedef std::string_view reference;
+    static const uint32_t kind = kBtreeFileString;
+
+    static stored store(const std::string& elem, std::string& data) {
+        stored slot{data.size(), elem.size()};
+        data += elem;
+        return slot;
+    }
+
+    // an empty string for characters that would run past the data
+    static reference view(const stored& slot, const char *data
+                        , size_t dataBytes) {
+        if (!fits(slot, dataBytes)) {
+            return std::string_view();
+        }
+        return std::string_view(data + slot.offset, slot.size);
+    }
+
+    static bool fits(const stored& slot, size_t dataBytes) {
+        return slot.offset <= dataBytes && slot.size <= dataBytes - slot.offset;
+    }
+};
+
+size_t btree_file_children_offset(const btree_file_header& header);
+btree_file_header btree_file_layout(uint32_t keyKind, size_t keyBytes
+                                  , size_t keyAlign);
+bool btree_file_check(const btree_file_header& header, uint32_t keyKind
+                    , size_t keyBytes, size_t keyAlign, size_t fileBytes);
+
+template <typename T, typename InputIt>
+bool btree_file_write(const std::string& path, InputIt first, size_t count);
+
+// btree_file
+inline size_t btree_file_children_offset(const btree_file_header& header) {
+    size_t end = header.keyOffset + header.nodeKeys * header.keyBytes;
+    return (end + alignof(uint32_t) - 1) / alignof(uint32_t)
+         * alignof(uint32_t);
+}
+
+/**
+ * A header with everything but the sizes of the tree filled in: as many
+ * keys as fit in a page, in the leaves and in the internal nodes.
+ */
+inline btree_file_header btree_file_layout(uint32_t keyKind, size_t keyBytes
+                                         , size_t keyAlign) {
+    btree_file_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "BTREEMAP", sizeof(header.magic));
+    header.version = kBtreeFileVersion;
+    header.endian = 0x01020304;
+    header.keyKind = keyKind;
+    header.keyBytes = static_cast<uint32_t>(keyBytes);
+    header.keyOffset = static_cast<uint32_t>(
+            (kBtreeFileNodeHeader + keyAlign - 1) / keyAlign * keyAlign);
+    header.pageBytes = kBtreeFilePage;
+    header.leafKeys = (kBtreeFilePage - header.keyOffset) / keyBytes;
+    header.nodeKeys = (kBtreeFilePage - header.keyOffset - sizeof(uint32_t))
+                    / (keyBytes + sizeof(uint32_t));
+    while (header.nodeKeys > 0 && btree_file_children_offset(header)
+            + (header.nodeKeys + 1) * sizeof(uint32_t) > kBtreeFilePage) {
+        --header.nodeKeys;
+    }
+    return header;
+}
+
+/**
+ * True if header describes a file of this version and byte order, with
+ * keys of the given kind, size and alignment, that fits in fileBytes.
+ */
+inline bool btree_file_check(const btree_file_header& header, uint32_t keyKind
+                           , size_t keyBytes, size_t keyAlign
+                           , size_t fileBytes) {
+    btree_file_header expected = btree_file_layout(keyKind, keyBytes
+                                                 , keyAlign);
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0
+            || header.version != expected.version
+            || header.endian != expected.endian
+            || header.keyKind != keyKind || header.keyBytes != keyBytes
+            || header.keyOffset != expected.keyOffset
+            || header.pageBytes != expected.pageBytes
+            || header.leafKeys != expected.leafKeys
+            || header.nodeKeys != expected.nodeKeys) {
+        return false;
+    }
+    // bound nodes by the file before multiplying, so the product can't
+    // wrap, and by the 32-bit child indices the writer stops at
+    if (fileBytes < header.pageBytes || header.nodes > UINT32_MAX
+            || header.nodes > fileBytes / header.pageBytes - 1) {
+        return false;
+    }
+    if (header.nodes > 0 ? header.root >= header.nodes : header.elems > 0) {
+        return false;
+    }
+    return header.dataOffset >= (header.nodes + 1) * header.pageBytes
+        && header.dataOffset <= fileBytes
+        && header.dataBytes <= fileBytes - header.dataOffset;
+}
+
+/**
+ * Writes the count strictly increasing elements from first to path, in
+ * the format above, building the tree a level at a time from the bottom
+ * as btree::bulk_load does. Nodes are filled up, with the elements spread
+ * evenly so none is left nearly empty. The file is written beside path,
+ * under a name of its own from mkstemp so that saves to the same path at
+ * the same time can't write into each other's file, and renamed over it
+ * at the end, so anyone who has the old file mapped keeps reading a whole
+ * tree. Returns false if the file couldn't be written.
+ */
+template <typename T, typename InputIt>
+bool btree_file_write(const std::string& path, InputIt first, size_t count) {
+    typedef btree_file_key<T> Key;
+    typedef typename Key::stored Stored;
+    btree_file_header header = btree_file_layout(Key::kind, sizeof(Stored)
+                                               , alignof(Stored));
+    if (header.nodeKeys < 2) {
+        return false;
+    }
+
+    std::string temp = path + ".XXXXXX";
+    int fd = ::mkstemp(&temp[0]);
+    if (fd < 0) {
+        return false;
+    }
+    // mkstemp makes the file readable by its owner only
+    ::fchmod(fd, 0644);
+    std::FILE *out = ::fdopen(fd, "wb");
+    if (out == nullptr) {
+        ::close(fd);
+        std::remove(temp.c_str());
+        return false;
+    }
+    std::vector<char> page(kBtreeFilePage);
+    std::fwrite(page.data(), 1, page.size(), out);
+
+    std::string data;
+    uint64_t nodes = 0;
+    auto writeNode = [&](const Stored *keys, size_t size
+                       , const uint64_t *children) {
+        std::fill(page.begin(), page.end(), 0);
+        uint32_t words[2] = {static_cast<uint32_t>(size), children == nullptr};
+        std::memcpy(page.data(), words, sizeof(words));
+        if (size > 0) {
+            std::memcpy(page.data() + header.keyOffset, keys
+                      , size * sizeof(Stored));
+        }
+        for (size_t i = 0; children != nullptr && i <= size; ++i) {
+            uint32_t child = static_cast<uint32_t>(children[i]);
+            std::memcpy(page.data() + btree_file_children_offset(header)
+                            + i * sizeof(uint32_t)
+                      , &child, sizeof(child));
+        }
+        std::fwrite(page.data(), 1, page.size(), out);
+        return nodes++;
+    };
+
+    // leaves: every leaf but the last is followed by a separator, and
+    // every leaf needs at least one element
+    std::vector<Stored> keys;
+    std::vector<Stored> separators;
+    std::vector<uint64_t> level;
+    if (count > 0) {
+        size_t target = header.leafKeys;
+        size_t leaves = (count + 1 + target) / (target + 1);
+        leaves = std::max<size_t>(1, std::min(leaves, (count + 1) / 2));
+        size_t leafElems = count - (leaves - 1);
+        for (size_t i = 0; i < leaves; ++i) {
+            keys.clear();
+            size_t elems = leafElems / leaves + (i < leafElems % leaves);
+            for (size_t j = 0; j < elems; ++j, ++first) {
+                keys.push_back(Key::store(*first, data));
+            }
+            level.push_back(writeNode(keys.data(), keys.size(), nullptr));
+            if (i + 1 < leaves) {
+                separators.push_back(Key::store(*first, data));
+                ++first;
+            }
+        }
+        header.height = 1;
+    }
+
+    // internal levels: group the children under as few parents as hold
+    // nodeKeys + 1 of them, but never fewer than two children a parent
+    while (level.size() > 1) {
+        size_t target = header.nodeKeys;
+        size_t children = level.size();
+        size_t parents = (children + target) / (target + 1);
+        parents = std::max<size_t>(1, std::min(parents, children / 2));
+
+        std::vector<uint64_t> above;
+        std::vector<Stored> aboveSeparators;
+        size_t next = 0;
+        for (size_t i = 0; i < parents; ++i) {
+            size_t group = children / parents + (i < children % parents);
+            above.push_back(writeNode(separators.data() + next, group - 1
+                                    , level.data() + next));
+            next += group;
+            if (i + 1 < parents) {
+                aboveSeparators.push_back(separators[next - 1]);
+            }
+        }
+        level.swap(above);
+        separators.swap(aboveSeparators);
+        ++header.height;
+    }
+
+    header.root = level.empty() ? 0 : level.front();
+    header.nodes = nodes;
+    header.elems = count;
+    header.dataOffset = (nodes + 1) * kBtreeFilePage;
+    header.dataBytes = data.size();
+    std::fwrite(data.data(), 1, data.size(), out);
+    std::fill(page.begin(), page.end(), 0);
+    std::memcpy(page.data(), &header, sizeof(header));
+    bool written = std::fseek(out, 0, SEEK_SET) == 0
+                && std::fwrite(page.data(), 1, page.size(), out) == page.size()
+                && !std::ferror(out);
+    written = std::fclose(out) == 0 && written;
+    if (!written || nodes > UINT32_MAX) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+#endif
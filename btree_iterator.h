@@ -1,8 +1,10 @@
 #ifndef BTREE_ITERATOR_H
 #define BTREE_ITERATOR_H
 
+#include <cstddef>
 #include <iterator>
-#include <cassert>
+#include <utility>
+#include <vector>
 /**
  * You MUST implement the btree iterators as (an) external class(es) in this file.
  * Failure to do so will result in a total mark of 0 for this deliverable.
@@ -11,24 +13,41 @@
 // iterator related interface stuff here; would be nice if you called your
 // iterator class btree_iterator (and possibly const_btree_iterator)
 
-template <typename T> class btree;
+template <typename, typename, typename, typename> class btree;
+template <typename T> class btree_node;
 
 template <typename T> class const_btree_iterator;
 
+/**
+ * The iterators are cursors into the live tree. They keep the path from the
+ * root down to the current element as (node, slot) pairs; every ancestor's
+ * slot names the child we descended into, which is also the element that
+ * comes next once that child is exhausted. An empty path is end().
+ *
+ * Moving to the first or last element costs one root-to-leaf descent,
+ * ++ and -- are amortised O(1). Like any B-Tree cursor, an iterator is
+ * invalidated by an insertion into or an erase from the tree it points into.
+ *
+ * As with std::set, elements can't be changed through either iterator:
+ * that could break the order, and nodes may be shared with copies of
+ * the tree, which would all see the change.
+ */
+
 // btree_iterator interface
 template <typename T>
 class btree_iterator {
+    template <typename, typename, typename, typename> friend class btree;
     friend class const_btree_iterator<T>;
 public:
     typedef std::bidirectional_iterator_tag    iterator_category;
     typedef T                                  value_type;
     typedef std::ptrdiff_t                     difference_type;
-    typedef T*                                 pointer;
-    typedef T&                                 reference;
-    
-    typedef typename btree<T>::Node Node;
-    typedef typename btree<T>::Node::Element Element;
-    
+    typedef const T*                           pointer;
+    typedef const T&                           reference;
+
+    typedef btree_node<T> Node;
+    typedef std::vector<std::pair<Node*, size_t>> Path;
+
     reference operator*() const;
     pointer operator->() const;
     btree_iterator& operator++();
@@ -39,31 +58,33 @@ public:
     bool operator==(const const_btree_iterator<T>& other) const;
     bool operator!=(const btree_iterator& other) const;
     bool operator!=(const const_btree_iterator<T>& other) const;
-    
-    btree_iterator(const btree<T>& tree, Element *pointee);
-    btree_iterator(const btree<T>& tree, std::string pos);
+
+    btree_iterator(Node *root, Path path = Path());
 private:
-    std::vector<std::shared_ptr<Element>> toVector(const btree<T>& tree);
-    
-    std::vector<std::shared_ptr<Element>> elems_;
-    unsigned int index_;
+    void descendLeftmost(Node *node);
+    void descendRightmost(Node *node);
+
+    Node *root_;
+    Path path_;
 };
 
 // const_btree_iterator interface
 template <typename T>
 class const_btree_iterator {
+    template <typename, typename, typename, typename> friend class btree;
     friend class btree_iterator<T>;
 public:
     typedef std::bidirectional_iterator_tag    iterator_category;
     typedef T                                  value_type;
     typedef std::ptrdiff_t                     difference_type;
-    typedef T*                                 pointer;
-    typedef T&                                 reference;
-    
-    typedef typename btree<T>::Node Node;
-    typedef typename btree<T>::Node::Element Element;
-    
-    
+    typedef const T*                           pointer;
+    typedef const T&                           reference;
+
+    typedef btree_node<T> Node;
+    typedef std::vector<std::pair<Node*, size_t>> Path;
+
+    reference operator*() const;
+    pointer operator->() const;
     const_btree_iterator& operator++();
     const_btree_iterator operator++(int);
     const_btree_iterator& operator--();
@@ -72,129 +93,125 @@ public:
     bool operator==(const btree_iterator<T>& other) const;
     bool operator!=(const const_btree_iterator& other) const;
     bool operator!=(const btree_iterator<T>& other) const;
-    const_btree_iterator(const btree<T>& tree, Element *pointee);
-    const_btree_iterator(const btree<T>& tree, std::string pos);
+
+    const_btree_iterator(Node *root, Path path = Path());
+    const_btree_iterator(const btree_iterator<T>& other);
+private:
+    void descendLeftmost(Node *node);
+    void descendRightmost(Node *node);
+
+    Node *root_;
+    Path path_;
+};
+
+/**
+ * A pair of iterators [first, last) into a tree, as returned by
+ * btree::range, with begin() and end() so it can be walked with a
+ * range-based for or handed to the standard algorithms.
+ */
+template <typename Iterator>
+class btree_range {
+public:
+    typedef Iterator iterator;
+
+    btree_range(Iterator first, Iterator last);
+
+    Iterator begin() const;
+    Iterator end() const;
+    bool empty() const;
+
 private:
-    std::vector<std::shared_ptr<Element>> toVector(const btree<T>& tree);
-    
-    std::vector<std::shared_ptr<Element>> elems_;
-    unsigned int index_;
+    Iterator first_;
+    Iterator last_;
 };
 
 // btree_iterator
 template <typename T>
-btree_iterator<T>::btree_iterator(const btree<T>& tree
-                                , typename btree<T>::Node::Element *elem)
-    : elems_{}
-    , index_{} {
-    elems_ = toVector(tree);
-    for(unsigned int i = 0; i < elems_.size(); ++i) {
-        if(elems_.at(0)->value_ == elem->value_) {
-            index_ = i;
-        }        
-    }
+btree_iterator<T>::btree_iterator(Node *root, Path path)
+    : root_{root}
+    , path_{std::move(path)} {
 }
 
 template <typename T>
-btree_iterator<T>::btree_iterator(const btree<T>& tree
-                                                , std::string pos)
-    : elems_{} 
-    , index_{} {
-    elems_ = toVector(tree);
-    if(pos == "begin") {
-        index_ = 0;
-    } else if (pos == "end") {
-        index_ = elems_.size();
+void btree_iterator<T>::descendLeftmost(Node *node) {
+    while (node != nullptr && !node->isEmpty()) {
+        path_.emplace_back(node, 0);
+        node = node->child(0);
     }
 }
 
 template <typename T>
-std::vector<std::shared_ptr<typename btree<T>::Node::Element>> 
-btree_iterator<T>::toVector(const btree<T>& tree) {
-    typedef typename btree<T>::Node Node;
-    typedef typename btree<T>::Node::Element Element;
-    
-    std::vector<std::shared_ptr<Element>> vector{};
-    auto nodesToPrint = std::queue<std::shared_ptr<Node>>();
-    
-    nodesToPrint.push(tree.root_);
-    while(!nodesToPrint.empty()) {
-        Node *node = nodesToPrint.front().get();
-        nodesToPrint.pop();
-        
-        auto elements = node->elems_;
-        
-        for (unsigned int i = 0; i < elements.size(); ++i) {
-        
-            vector.push_back(std::make_shared<Element>(elements.at(i)));
-        }
-        
-        if(elements.size() == tree.maxNodeElems_) {
-            auto firstElement = elements.at(0);
-            std::shared_ptr<Node> leftChildPtr = firstElement.getLeftChild();
-            std::shared_ptr<Node> rightChildPtr = firstElement.getRightChild();
-            if(!leftChildPtr.get()->isEmpty()) {
-                nodesToPrint.push(leftChildPtr);
-            }
-            if(!rightChildPtr.get()->isEmpty()) {
-                nodesToPrint.push(rightChildPtr);
-            }
-            for (unsigned int i = 1; i < elements.size(); i++) {
-                auto currElement = elements.at(i);
-                rightChildPtr = currElement.getRightChild();
-                if(!rightChildPtr.get()->isEmpty()) {
-                    nodesToPrint.push(rightChildPtr);
-                }
-            }
+void btree_iterator<T>::descendRightmost(Node *node) {
+    while (node != nullptr && !node->isEmpty()) {
+        size_t last = node->size();
+        Node *child = node->child(last);
+        if (child == nullptr) {
+            path_.emplace_back(node, last - 1);
+            return;
         }
-        
+        path_.emplace_back(node, last);
+        node = child;
     }
-    std::sort( vector.begin( ), vector.end( )
-        , [ ]( const std::shared_ptr<Element>& lhs
-                , const std::shared_ptr<Element>& rhs ) {
-                    return lhs.get()->getValue() < rhs.get()->getValue();
-                });
-    return vector;
 }
 
-template <typename T> typename btree_iterator<T>::reference 
+template <typename T> typename btree_iterator<T>::reference
 btree_iterator<T>::operator*() const {
-    return elems_.at(index_).get()->value_;
+    return path_.back().first->value(path_.back().second);
 }
 
-template <typename T>
-T* btree_iterator<T>::operator->() const {
+template <typename T> typename btree_iterator<T>::pointer
+btree_iterator<T>::operator->() const {
     return &(operator*());
 }
 
-//TODO
-template <typename T> btree_iterator<T>& 
+template <typename T> btree_iterator<T>&
 btree_iterator<T>::operator++() {
-    if(index_ == elems_.size()) {
+    if (path_.empty()) {
+        return *this;
+    }
+    Node *node = path_.back().first;
+    size_t next = ++path_.back().second;
+    Node *child = node->child(next);
+    if (child != nullptr) {
+        descendLeftmost(child);
         return *this;
-    } 
-    index_++;
+    }
+    while (!path_.empty() && path_.back().second == path_.back().first->size()) {
+        path_.pop_back();
+    }
     return *this;
 }
 
 template <typename T> btree_iterator<T>
-btree_iterator<T>::operator++(int dummy) {
+btree_iterator<T>::operator++(int) {
     btree_iterator<T> result(*this);
     ++(*this);
     return result;
 }
 
-template <typename T> btree_iterator<T>& 
+template <typename T> btree_iterator<T>&
 btree_iterator<T>::operator--() {
-    if(index_ == 0) {
+    if (path_.empty()) {
+        descendRightmost(root_);
+        return *this;
+    }
+    Node *node = path_.back().first;
+    Node *child = node->child(path_.back().second);
+    if (child != nullptr) {
+        descendRightmost(child);
         return *this;
-    } 
-    index_--;
+    }
+    while (!path_.empty() && path_.back().second == 0) {
+        path_.pop_back();
+    }
+    if (!path_.empty()) {
+        --path_.back().second;
+    }
     return *this;
 }
 
 template <typename T> btree_iterator<T>
-btree_iterator<T>::operator--(int dummy) {
+btree_iterator<T>::operator--(int) {
     btree_iterator<T> result(*this);
     --(*this);
     return result;
@@ -202,23 +219,18 @@ btree_iterator<T>::operator--(int dummy) {
 
 template <typename T>
 bool btree_iterator<T>::operator==(const btree_iterator& other) const {
-    if (index_ == other.index_) return true;
-    
-    if(index_ >= elems_.size() && other.index_ >= other.elems_.size())
-        return true;
-    
-    return false;
+    if (path_.empty() || other.path_.empty()) {
+        return path_.empty() && other.path_.empty();
+    }
+    return path_.back() == other.path_.back();
 }
 
 template <typename T>
 bool btree_iterator<T>::operator==(const const_btree_iterator<T>& other) const {
-
-    if (index_ == other.index_) return true;
-    
-    if(index_ >= elems_.size() && other.index_ >= other.elems_.size())
-        return true;
-    
-    return false;
+    if (path_.empty() || other.path_.empty()) {
+        return path_.empty() && other.path_.empty();
+    }
+    return path_.back() == other.path_.back();
 }
 
 template <typename T>
@@ -233,131 +245,114 @@ bool btree_iterator<T>::operator!=(const const_btree_iterator<T>& other) const {
 
 //const_btree_iterator
 template <typename T>
-const_btree_iterator<T>::const_btree_iterator(const btree<T>& tree
-                                    , typename btree<T>::Node::Element *elem)
-    : elems_{}
-    , index_{} {
-    elems_ = toVector(tree);
-    for(unsigned int i = 0; i < elems_.size(); ++i) {
-        if(elems_.at(0)->getValue() == elem->getValue()) {
-            index_ = i;
-        }        
-    }
+const_btree_iterator<T>::const_btree_iterator(Node *root, Path path)
+    : root_{root}
+    , path_{std::move(path)} {
+}
+
+template <typename T>
+const_btree_iterator<T>::const_btree_iterator(const btree_iterator<T>& other)
+    : root_{other.root_}
+    , path_{other.path_} {
 }
 
 template <typename T>
-const_btree_iterator<T>::const_btree_iterator(const btree<T>& tree
-                                                            , std::string pos)
-    : elems_{} 
-    , index_{} {
-    elems_ = toVector(tree);
-    if(pos == "begin") {
-        index_ = 0;
-    } else if (pos == "end") {
-        index_ = elems_.size();
+void const_btree_iterator<T>::descendLeftmost(Node *node) {
+    while (node != nullptr && !node->isEmpty()) {
+        path_.emplace_back(node, 0);
+        node = node->child(0);
     }
 }
 
 template <typename T>
-std::vector<std::shared_ptr<typename btree<T>::Node::Element>> 
-const_btree_iterator<T>::toVector(const btree<T>& tree) {
-    typedef typename btree<T>::Node Node;
-    typedef typename btree<T>::Node::Element Element;
-    
-    std::vector<std::shared_ptr<Element>> vector{};
-    auto nodesToPrint = std::queue<std::shared_ptr<Node>>();
-    
-    nodesToPrint.push(tree.root_);
-    while(!nodesToPrint.empty()) {
-        Node *node = nodesToPrint.front().get();
-        nodesToPrint.pop();
-        
-        auto elements = node->elems_;
-        
-        for (unsigned int i = 0; i < elements.size(); ++i) {
-        
-            vector.push_back(std::make_shared<Element>(elements.at(i)));
+void const_btree_iterator<T>::descendRightmost(Node *node) {
+    while (node != nullptr && !node->isEmpty()) {
+        size_t last = node->size();
+        Node *child = node->child(last);
+        if (child == nullptr) {
+            path_.emplace_back(node, last - 1);
+            return;
         }
-        
-        if(elements.size() == tree.maxNodeElems_) {
-            auto firstElement = elements.at(0);
-            std::shared_ptr<Node> leftChildPtr = firstElement.getLeftChild();
-            std::shared_ptr<Node> rightChildPtr = firstElement.getRightChild();
-            if(!leftChildPtr.get()->isEmpty()) {
-                nodesToPrint.push(leftChildPtr);
-            }
-            if(!rightChildPtr.get()->isEmpty()) {
-                nodesToPrint.push(rightChildPtr);
-            }
-            for (unsigned int i = 1; i < elements.size(); i++) {
-                auto currElement = elements.at(i);
-                rightChildPtr = currElement.getRightChild();
-                if(!rightChildPtr.get()->isEmpty()) {
-                    nodesToPrint.push(rightChildPtr);
-                }
-            }
-        }
-        
+        path_.emplace_back(node, last);
+        node = child;
     }
-    std::sort( vector.begin( ), vector.end( )
-        , [ ]( const std::shared_ptr<Element>& lhs
-                , const std::shared_ptr<Element>& rhs ) {
-                    return lhs.get()->getValue() < rhs.get()->getValue();
-                });
-    return vector;
 }
 
-template <typename T> const_btree_iterator<T>& 
+template <typename T> typename const_btree_iterator<T>::reference
+const_btree_iterator<T>::operator*() const {
+    return path_.back().first->value(path_.back().second);
+}
+
+template <typename T>
+const T* const_btree_iterator<T>::operator->() const {
+    return &(operator*());
+}
+
+template <typename T> const_btree_iterator<T>&
 const_btree_iterator<T>::operator++() {
-    if(index_ == elems_.size()) {
+    if (path_.empty()) {
+        return *this;
+    }
+    Node *node = path_.back().first;
+    size_t next = ++path_.back().second;
+    Node *child = node->child(next);
+    if (child != nullptr) {
+        descendLeftmost(child);
         return *this;
-    } 
-    index_++;
+    }
+    while (!path_.empty() && path_.back().second == path_.back().first->size()) {
+        path_.pop_back();
+    }
     return *this;
 }
 
 template <typename T> const_btree_iterator<T>
-const_btree_iterator<T>::operator++(int dummy) {
-    btree_iterator<T> result(*this);
+const_btree_iterator<T>::operator++(int) {
+    const_btree_iterator<T> result(*this);
     ++(*this);
     return result;
 }
 
-template <typename T> const_btree_iterator<T>& 
+template <typename T> const_btree_iterator<T>&
 const_btree_iterator<T>::operator--() {
-    if(index_ == 0) {
+    if (path_.empty()) {
+        descendRightmost(root_);
         return *this;
-    } 
-    index_--;
+    }
+    Node *node = path_.back().first;
+    Node *child = node->child(path_.back().second);
+    if (child != nullptr) {
+        descendRightmost(child);
+        return *this;
+    }
+    while (!path_.empty() && path_.back().second == 0) {
+        path_.pop_back();
+    }
+    if (!path_.empty()) {
+        --path_.back().second;
+    }
     return *this;
 }
 
 template <typename T> const_btree_iterator<T>
-const_btree_iterator<T>::operator--(int dummy) {
-    btree_iterator<T> result(*this);
+const_btree_iterator<T>::operator--(int) {
+    const_btree_iterator<T> result(*this);
     --(*this);
     return result;
 }
-    
+
 
 template <typename T>
 bool const_btree_iterator<T>::operator==(const const_btree_iterator& other) const {
-    if (index_ == other.index_) return true;
-    
-    if(index_ >= elems_.size() && other.index_ >= other.elems_.size())
-        return true;
-    
-    return false;
+    if (path_.empty() || other.path_.empty()) {
+        return path_.empty() && other.path_.empty();
+    }
+    return path_.back() == other.path_.back();
 }
 
 template <typename T>
 bool const_btree_iterator<T>::operator==(const btree_iterator<T>& other) const {
-    if (index_ == other.index_) return true;
-    
-    if(index_ >= elems_.size() && other.index_ >= other.elems_.size())
-        return true;
-    
-    return false;
+    return other == *this;
 }
 
 template <typename T>
@@ -370,4 +365,26 @@ bool const_btree_iterator<T>::operator!=(const btree_iterator<T>& other) const {
     return !operator==(other);
 }
 
+// btree_range
+template <typename Iterator>
+btree_range<Iterator>::btree_range(Iterator first, Iterator last)
+    : first_{std::move(first)}
+    , last_{std::move(last)} {
+}
+
+template <typename Iterator>
+Iterator btree_range<Iterator>::begin() const {
+    return first_;
+}
+
+template <typename Iterator>
+Iterator btree_range<Iterator>::end() const {
+    return last_;
+}
+
+template <typename Iterator>
+bool btree_range<Iterator>::empty() const {
+    return first_ == last_;
+}
+
 #endif
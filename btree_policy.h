@@ -0,0 +1,73 @@
+#ifndef BTREE_POLICY_H
+#define BTREE_POLICY_H
+
+#include <cstddef>
+
+/**
+ * Optional node features, picked at compile time through the btree's
+ * last template parameter. A policy is a struct of static constants;
+ * deriving from btree_default_policy and overriding one of them keeps
+ * the defaults for the rest.
+ *
+ * counted: every internal node also keeps, next to each child pointer,
+ *     the number of elements in that child's subtree. rank() and
+ *     select() then run in O(log n) instead of walking from begin(), for
+ *     one size_t per child and the upkeep of the counts on every insert
+ *     and erase. Trees without it don't pay for either.
+ *
+ * instrumented: the tree counts its lookups, the nodes and comparisons
+ *     they take, its splits and its node allocations, for counters() to
+ *     report (see btree_stats.h). Node searches then go through the
+ *     comparator, to count its calls, rather than the vector kernels.
+ *     Other trees keep no counts and the counting compiles away.
+ *
+ * node_elems: a node capacity fixed at compile time, in place of the
+ *     maxNodeElems the tree is constructed with, which is then ignored.
+ *     The tree's capacity checks and node layout become constants, the
+ *     lookups reach the child pointers at a fixed offset, and the search
+ *     of a node by the comparator runs a fixed number of halving steps
+ *     the compiler can unroll. 0, the default, leaves it to run time.
+ *
+ * node_bytes: fixes the capacity at compile time too, from the key type:
+ *     as many keys as fit in a leaf of node_bytes bytes, header included,
+ *     and at least 2. Internal nodes are that much bigger again for their
+ *     child pointers. Ignored if node_elems is set.
+ *
+ * To combine features, derive from one policy and set the other, e.g.
+ *
+ *     struct counted_instrumented : btree_counted_policy {
+ *         static constexpr bool instrumented = true;
+ *     };
+ */
+
+struct btree_default_policy {
+    static constexpr bool counted = false;
+    static constexpr bool instrumented = false;
+    static constexpr size_t node_elems = 0;
+    static constexpr size_t node_bytes = 0;
+};
+
+struct btree_counted_policy : btree_default_policy {
+    static constexpr bool counted = true;
+};
+
+struct btree_instrumented_policy : btree_default_policy {
+    static constexpr bool instrumented = true;
+};
+
+template <size_t N>
+struct btree_fixed_policy : btree_default_policy {
+    static_assert(N >= 2, "a node must hold at least 2 elements");
+    static constexpr size_t node_elems = N;
+};
+
+/**
+ * Leaves of eight cache lines by default, which holds 62 longs; a page,
+ * 4096, suits trees that mostly live out of cache.
+ */
+template <size_t Bytes = 512>
+struct btree_fitted_policy : btree_default_policy {
+    static constexpr size_t node_bytes = Bytes;
+};
+
+#endif
@@ -0,0 +1,364 @@
+#ifndef BTREE_SEARCH_H
+#define BTREE_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if !defined(BTREE_NO_SIMD) && (defined(__SSE2__) || defined(__AVX2__))
+#include <immintrin.h>
+#endif
+
+/**
+ * Searching within a node: given the node's sorted, contiguous keys,
+ * find the first slot whose key is not less than elem.
+ *
+ * The generic version is a branch-free binary search relying only on
+ * operator<. Signed integers of 32 or 64 bits, floats and doubles get a
+ * vector kernel instead, picked at compile time from T: once the search
+ * is down to 16 keys it compares them all against elem in a few vector
+ * instructions and counts how many are less. Which instructions are used
+ * depends on what the compiler is allowed to emit (AVX2, SSE4.2, SSE2);
+ * without any of them, or with BTREE_NO_SIMD defined, every type takes
+ * the scalar path.
+ */
+
+enum class btree_search_kernel { scalar, int32, int64, float32, float64 };
+
+template <typename T>
+struct btree_search_kernel_for {
+    static constexpr btree_search_kernel value =
+        !std::is_arithmetic<T>::value || std::is_same<T, bool>::value
+            ? btree_search_kernel::scalar
+        : std::is_same<T, float>::value ? btree_search_kernel::float32
+        : std::is_same<T, double>::value ? btree_search_kernel::float64
+        : std::is_integral<T>::value && std::is_signed<T>::value
+                && sizeof(T) == 4 ? btree_search_kernel::int32
+        : std::is_integral<T>::value && std::is_signed<T>::value
+                && sizeof(T) == 8 ? btree_search_kernel::int64
+        : btree_search_kernel::scalar;
+};
+
+template <typename T
+        , btree_search_kernel Kernel = btree_search_kernel_for<T>::value>
+struct btree_node_search {
+    static size_t scalar(const T *keys, size_t size, const T& elem);
+    static size_t lowerBound(const T *keys, size_t size, const T& elem);
+};
+
+template <typename T, btree_search_kernel Kernel>
+size_t btree_node_search<T, Kernel>::scalar(const T *keys, size_t size
+                                          , const T& elem) {
+    // halving without an early exit keeps the loop free of data-dependent
+    // branches
+    if (size == 0) {
+        return 0;
+    }
+    const T *base = keys;
+    while (size > 1) {
+        size_t half = size / 2;
+        base = (base[half] < elem) ? base + half : base;
+        size -= half;
+    }
+    return (base - keys) + (*base < elem);
+}
+
+template <typename T, btree_search_kernel Kernel>
+size_t btree_node_search<T, Kernel>::lowerBound(const T *keys, size_t size
+                                              , const T& elem) {
+    return scalar(keys, size, elem);
+}
+
+/**
+ * The same halving under an arbitrary ordering, for comparators other
+ * than plain operator< and for lookups by something other than a T.
+ */
+template <typename T, typename K, typename Compare>
+size_t btree_lower_bound(const T *keys, size_t size, const K& elem
+                       , const Compare& comp) {
+    if (size == 0) {
+        return 0;
+    }
+    const T *base = keys;
+    while (size > 1) {
+        size_t half = size / 2;
+        base = comp(base[half], elem) ? base + half : base;
+        size -= half;
+    }
+    return (base - keys) + comp(*base, elem);
+}
+
+/**
+ * The same search for nodes of at most N keys, with N known at compile
+ * time: below counts the keys known to be less than elem, and each step
+ * tries to add the next smaller power of two to it. The number of steps
+ * only depends on N, so the loop unrolls into a straight run of compares
+ * and conditional moves.
+ */
+template <size_t N, typename T, typename K, typename Compare>
+size_t btree_lower_bound_fixed(const T *keys, size_t size, const K& elem
+                             , const Compare& comp) {
+    size_t top = 1;
+    while (top * 2 <= N) {
+        top *= 2;
+    }
+    size_t below = 0;
+    for (size_t step = top; step > 0; step /= 2) {
+        size_t probe = below + step;
+        below = (probe <= size && comp(keys[probe - 1], elem)) ? probe : below;
+    }
+    return below;
+}
+
+/**
+ * Halving on a three-way comparison, one call per probe. found is set
+ * when elem is in the node, in which case the returned slot is its own.
+ * An equal key is always among those probed: keys dropped off the bottom
+ * of the range compared less, and those dropped off the top are greater
+ * than one that was probed and found not less.
+ */
+template <typename T, typename K, typename ThreeWay>
+size_t btree_lower_bound(const T *keys, size_t size, const K& elem
+                       , const ThreeWay& compare, bool& found) {
+    found = false;
+    if (size == 0) {
+        return 0;
+    }
+    const T *base = keys;
+    const T *match = nullptr;
+    while (size > 1) {
+        size_t half = size / 2;
+        int order = compare(base[half], elem);
+        match = (order == 0) ? base + half : match;
+        base = (order < 0) ? base + half : base;
+        size -= half;
+    }
+    int order = compare(*base, elem);
+    match = (order == 0) ? base : match;
+    found = (match != nullptr);
+    return found ? match - keys : (base - keys) + (order < 0);
+}
+
+/**
+ * The fixed-step search on a three-way comparison. An equal key is always
+ * probed: the first key not less than elem is the one at below, and the
+ * step that would have taken below past it was turned down on that key.
+ */
+template <size_t N, typename T, typename K, typename ThreeWay>
+size_t btree_lower_bound_fixed(const T *keys, size_t size, const K& elem
+                             , const ThreeWay& compare, bool& found) {
+    size_t top = 1;
+    while (top * 2 <= N) {
+        top *= 2;
+    }
+    size_t below = 0;
+    bool match = false;
+    for (size_t step = top; step > 0; step /= 2) {
+        size_t probe = below + step;
+        if (probe <= size) {
+            int order = compare(keys[probe - 1], elem);
+            match = match || order == 0;
+            below = (order < 0) ? probe : below;
+        }
+    }
+    found = match;
+    return below;
+}
+
+/**
+ * Asks for the cache lines covering [block, block + bytes) to be loaded
+ * ahead of use, for searches that know which node they visit next well
+ * before they get to it. A no-op where the compiler has no prefetch.
+ */
+inline void btree_prefetch(const void *block, size_t bytes) {
+#if defined(__GNUC__) || defined(__clang__)
+    const size_t kLine = 64;
+    const char *line = static_cast<const char*>(block);
+    for (size_t offset = 0; offset < bytes; offset += kLine) {
+        __builtin_prefetch(line + offset);
+    }
+#else
+    (void) block;
+    (void) bytes;
+#endif
+}
+
+#if !defined(BTREE_NO_SIMD) && (defined(__SSE2__) || defined(__AVX2__))
+
+/**
+ * Shared driver for the vector kernels: branch-free halving narrows the
+ * node down to a window of kWindow keys known to hold the answer, then
+ * Kernel::countLess compares the whole window against elem with a few
+ * vector instructions. The window is pulled back to stay inside the
+ * node's keys, which only shifts where the count starts.
+ */
+template <typename T, typename Kernel>
+size_t btree_vector_lower_bound(const T *keys, size_t size, const T& elem) {
+    const size_t window = Kernel::kWindow;
+    if (size < window) {
+        size_t count = 0;
+        for (size_t i = 0; i < size; ++i) {
+            count += (keys[i] < elem);
+        }
+        return count;
+    }
+    const T *base = keys;
+    size_t len = size;
+    while (len > window) {
+        size_t half = len / 2;
+        base = (base[half] < elem) ? base + half : base;
+        len -= half;
+    }
+    size_t start = static_cast<size_t>(base - keys);
+    if (start > size - window) {
+        start = size - window;
+    }
+    return start + Kernel::countLess(keys + start, elem);
+}
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+// 64-bit integer compares need SSE4.2, plain SSE2 keeps the binary search
+template <typename T>
+struct btree_node_search<T, btree_search_kernel::int64> {
+    static const size_t kWindow = 16;
+
+    static size_t scalar(const T *keys, size_t size, const T& elem) {
+        return btree_node_search<T, btree_search_kernel::scalar>::scalar(
+                keys, size, elem);
+    }
+
+    static size_t lowerBound(const T *keys, size_t size, const T& elem) {
+        return btree_vector_lower_bound<T, btree_node_search>(keys, size, elem);
+    }
+
+    static unsigned countLess(const T *window, const T& elem) {
+        unsigned count = 0;
+#if defined(__AVX2__)
+        const __m256i needle = _mm256_set1_epi64x(elem);
+        for (size_t i = 0; i < kWindow; i += 4) {
+            __m256i chunk = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(window + i));
+            count += __builtin_popcount(_mm256_movemask_pd(
+                    _mm256_castsi256_pd(_mm256_cmpgt_epi64(needle, chunk))));
+        }
+#else
+        const __m128i needle = _mm_set1_epi64x(elem);
+        for (size_t i = 0; i < kWindow; i += 2) {
+            __m128i chunk = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(window + i));
+            count += __builtin_popcount(_mm_movemask_pd(
+                    _mm_castsi128_pd(_mm_cmpgt_epi64(needle, chunk))));
+        }
+#endif
+        return count;
+    }
+};
+#endif
+
+template <typename T>
+struct btree_node_search<T, btree_search_kernel::int32> {
+    static const size_t kWindow = 16;
+
+    static size_t scalar(const T *keys, size_t size, const T& elem) {
+        return btree_node_search<T, btree_search_kernel::scalar>::scalar(
+                keys, size, elem);
+    }
+
+    static size_t lowerBound(const T *keys, size_t size, const T& elem) {
+        return btree_vector_lower_bound<T, btree_node_search>(keys, size, elem);
+    }
+
+    static unsigned countLess(const T *window, const T& elem) {
+        unsigned count = 0;
+#if defined(__AVX2__)
+        const __m256i needle = _mm256_set1_epi32(elem);
+        for (size_t i = 0; i < kWindow; i += 8) {
+            __m256i chunk = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(window + i));
+            count += __builtin_popcount(_mm256_movemask_ps(
+                    _mm256_castsi256_ps(_mm256_cmpgt_epi32(needle, chunk))));
+        }
+#else
+        const __m128i needle = _mm_set1_epi32(elem);
+        for (size_t i = 0; i < kWindow; i += 4) {
+            __m128i chunk = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(window + i));
+            count += __builtin_popcount(_mm_movemask_ps(
+                    _mm_castsi128_ps(_mm_cmpgt_epi32(needle, chunk))));
+        }
+#endif
+        return count;
+    }
+};
+
+template <>
+struct btree_node_search<double, btree_search_kernel::float64> {
+    static const size_t kWindow = 16;
+
+    static size_t scalar(const double *keys, size_t size, const double& elem) {
+        return btree_node_search<double, btree_search_kernel::scalar>::scalar(
+                keys, size, elem);
+    }
+
+    static size_t lowerBound(const double *keys, size_t size
+                           , const double& elem) {
+        return btree_vector_lower_bound<double, btree_node_search>(
+                keys, size, elem);
+    }
+
+    static unsigned countLess(const double *window, const double& elem) {
+        unsigned count = 0;
+#if defined(__AVX2__)
+        const __m256d needle = _mm256_set1_pd(elem);
+        for (size_t i = 0; i < kWindow; i += 4) {
+            count += __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(
+                    _mm256_loadu_pd(window + i), needle, _CMP_LT_OQ)));
+        }
+#else
+        const __m128d needle = _mm_set1_pd(elem);
+        for (size_t i = 0; i < kWindow; i += 2) {
+            count += __builtin_popcount(_mm_movemask_pd(
+                    _mm_cmplt_pd(_mm_loadu_pd(window + i), needle)));
+        }
+#endif
+        return count;
+    }
+};
+
+template <>
+struct btree_node_search<float, btree_search_kernel::float32> {
+    static const size_t kWindow = 16;
+
+    static size_t scalar(const float *keys, size_t size, const float& elem) {
+        return btree_node_search<float, btree_search_kernel::scalar>::scalar(
+                keys, size, elem);
+    }
+
+    static size_t lowerBound(const float *keys, size_t size
+                           , const float& elem) {
+        return btree_vector_lower_bound<float, btree_node_search>(
+                keys, size, elem);
+    }
+
+    static unsigned countLess(const float *window, const float& elem) {
+        unsigned count = 0;
+#if defined(__AVX2__)
+        const __m256 needle = _mm256_set1_ps(elem);
+        for (size_t i = 0; i < kWindow; i += 8) {
+            count += __builtin_popcount(_mm256_movemask_ps(_mm256_cmp_ps(
+                    _mm256_loadu_ps(window + i), needle, _CMP_LT_OQ)));
+        }
+#else
+        const __m128 needle = _mm_set1_ps(elem);
+        for (size_t i = 0; i < kWindow; i += 4) {
+            count += __builtin_popcount(_mm_movemask_ps(
+                    _mm_cmplt_ps(_mm_loadu_ps(window + i), needle)));
+        }
+#endif
+        return count;
+    }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef BTREE_STATS_H
+#define BTREE_STATS_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * What btree::stats reports about the shape of a tree, from one walk
+ * over every node.
+ *
+ * levelNodes holds the number of nodes at each level, the root's first.
+ * fillHistogram sorts the nodes by how full they are, in tenths of
+ * maxNodeElems: bucket i counts nodes holding at least i tenths and
+ * less than i + 1, and the last bucket takes full nodes too. bytes is
+ * what the node blocks take from the allocator; memory the keys
+ * themselves own, such as a long std::string's buffer, isn't included.
+ */
+const size_t kBtreeFillBuckets = 10;
+
+struct btree_stats {
+    size_t size = 0;
+    size_t height = 0;
+    size_t nodes = 0;
+    std::vector<size_t> levelNodes;
+    std::array<size_t, kBtreeFillBuckets> fillHistogram{};
+    double fill = 0;
+    size_t bytes = 0;
+    double bytesPerKey = 0;
+};
+
+/**
+ * The counts an instrumented btree keeps (see btree_policy.h) since it
+ * was made or its counters were last reset:
+ *
+ *   lookups      descents from the root by a find, bound, insert or
+ *                erase, or by each probe of a batch lookup
+ *   nodesVisited nodes searched on the way down by those lookups
+ *   comparisons  calls to the comparator while searching nodes
+ *   splits       nodes split because they were full
+ *   allocations  nodes taken from the allocator, including those copied
+ *                from nodes shared with another tree
+ *
+ * so comparisons / lookups is the cost of a find, and nodesVisited /
+ * lookups the depth it goes to.
+ */
+struct btree_counters {
+    uint64_t lookups = 0;
+    uint64_t nodesVisited = 0;
+    uint64_t comparisons = 0;
+    uint64_t splits = 0;
+    uint64_t allocations = 0;
+};
+
+/**
+ * Where an instrumented tree keeps its counts while it runs. They are
+ * atomic, added to relaxed, so const lookups from several threads at
+ * once can each count theirs. A copy of the tree starts from zero.
+ */
+class btree_counter_cells {
+public:
+    btree_counter_cells() = default;
+    btree_counter_cells(const btree_counter_cells&) {}
+    btree_counter_cells& operator=(const btree_counter_cells&) {
+        return *this;
+    }
+
+    void lookup() {
+        lookups_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void visit() {
+        nodesVisited_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void compared(size_t comparisons) {
+        comparisons_.fetch_add(comparisons, std::memory_order_relaxed);
+    }
+
+    void split() {
+        splits_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void allocate() {
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    btree_counters load() const {
+        btree_counters counters;
+        counters.lookups = lookups_.load(std::memory_order_relaxed);
+        counters.nodesVisited = nodesVisited_.load(std::memory_order_relaxed);
+        counters.comparisons = comparisons_.load(std::memory_order_relaxed);
+        counters.splits = splits_.load(std::memory_order_relaxed);
+        counters.allocations = allocations_.load(std::memory_order_relaxed);
+        return counters;
+    }
+
+    void reset() {
+        lookups_.store(0, std::memory_order_relaxed);
+        nodesVisited_.store(0, std::memory_order_relaxed);
+        comparisons_.store(0, std::memory_order_relaxed);
+        splits_.store(0, std::memory_order_relaxed);
+        allocations_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> lookups_{0};
+    std::atomic<uint64_t> nodesVisited_{0};
+    std::atomic<uint64_t> comparisons_{0};
+    std::atomic<uint64_t> splits_{0};
+    std::atomic<uint64_t> allocations_{0};
+};
+
+/**
+ * What every other tree keeps in its place: the same calls, doing
+ * nothing, so they compile away along with what was being counted.
+ */
+struct btree_no_counters {
+    void lookup() {}
+    void visit() {}
+    void compared(size_t) {}
+    void split() {}
+    void allocate() {}
+    void reset() {}
+};
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef BTREE_THREAD_POOL_H
+#define BTREE_THREAD_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads for splitting a loop over [0, count) into
+ * chunks, as btree::find_many does with its probes. The thread that calls
+ * parallel_for works through chunks alongside the workers and returns
+ * once every chunk is done.
+ *
+ * Chunks are dealt out evenly up front, a contiguous run to each thread.
+ * A thread works its own run from the front; once that is empty it
+ * steals single chunks off the back of the others' runs, so threads that
+ * are held up or given slower chunks don't leave the rest waiting at the
+ * end.
+ *
+ * One parallel_for runs at a time: calls from several threads queue up.
+ * The body must not throw, nor call parallel_for on the same pool.
+ */
+class btree_thread_pool {
+public:
+    /**
+     * @param threads the number of worker threads to start, besides the
+     *        threads that will be calling parallel_for
+     */
+    explicit btree_thread_pool(size_t threads);
+    ~btree_thread_pool();
+
+    btree_thread_pool(const btree_thread_pool&) = delete;
+    btree_thread_pool& operator=(const btree_thread_pool&) = delete;
+
+    /**
+     * A pool shared by the whole program, started on first use with a
+     * worker for every hardware thread but the caller's.
+     */
+    static btree_thread_pool& shared();
+
+    /**
+     * The number of threads a parallel_for runs on, the caller included.
+     */
+    size_t concurrency() const;
+
+    /**
+     * Calls body(from, to) on consecutive ranges of at most grain indices
+     * covering [0, count), from as many threads as there are chunks to go
+     * round.
+     */
+    template <typename Body>
+    void parallel_for(size_t count, size_t grain, Body body);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        size_t front = 0;
+        size_t back = 0;
+    };
+
+    template <typename Chunk>
+    static void runChunk(const void *chunk, size_t index);
+
+    void loop(size_t self);
+    void work(size_t self);
+    bool take(size_t self, size_t& index);
+    bool steal(size_t self, size_t& index);
+
+    std::vector<std::thread> threads_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+
+    // the job in hand: a chunk is run as run_(chunk_, index)
+    void (*run_)(const void *, size_t);
+    const void *chunk_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    size_t generation_;
+    size_t active_;
+    bool stop_;
+    std::mutex jobs_;
+};
+
+// btree_thread_pool
+inline btree_thread_pool::btree_thread_pool(size_t threads)
+    : threads_{}
+    , queues_{}
+    , run_{nullptr}
+    , chunk_{nullptr}
+    , mutex_{}
+    , wake_{}
+    , done_{}
+    , generation_{0}
+    , active_{0}
+    , stop_{false}
+    , jobs_{} {
+    // the last queue is the calling thread's
+    for (size_t i = 0; i <= threads; ++i) {
+        queues_.emplace_back(new Queue());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back([this, i]() { loop(i); });
+    }
+}
+
+inline btree_thread_pool::~btree_thread_pool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+inline btree_thread_pool& btree_thread_pool::shared() {
+    static btree_thread_pool pool(
+            std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+inline size_t btree_thread_pool::concurrency() const {
+    return threads_.size() + 1;
+}
+
+template <typename Body>
+void btree_thread_pool::parallel_for(size_t count, size_t grain, Body body) {
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = (count + grain - 1) / grain;
+    auto chunk = [&](size_t index) {
+        size_t from = index * grain;
+        body(from, std::min(count, from + grain));
+    };
+    if (threads_.empty() || chunks <= 1) {
+        for (size_t index = 0; index < chunks; ++index) {
+            chunk(index);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> job(jobs_);
+    size_t queues = queues_.size();
+    for (size_t i = 0; i < queues; ++i) {
+        queues_[i]->front = i * chunks / queues;
+        queues_[i]->back = (i + 1) * chunks / queues;
+    }
+    run_ = &runChunk<decltype(chunk)>;
+    chunk_ = &chunk;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_ = threads_.size();
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    work(threads_.size());
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return active_ == 0; });
+}
+
+template <typename Chunk>
+void btree_thread_pool::runChunk(const void *chunk, size_t index) {
+    (*static_cast<const Chunk*>(chunk))(index);
+}
+
+inline void btree_thread_pool::loop(size_t self) {
+    size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&]() { return stop_ || generation_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+        }
+        work(self);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--active_ == 0) {
+            done_.notify_all();
+        }
+    }
+}
+
+/**
+ * Runs chunks until there are none left anywhere. A chunk is only ever
+ * taken by the thread that runs it, so once every thread is out of here
+ * the job is done.
+ */
+inline void btree_thread_pool::work(size_t self) {
+    size_t index = 0;
+    while (take(self, index) || steal(self, index)) {
+        run_(chunk_, index);
+    }
+}
+
+inline bool btree_thread_pool::take(size_t self, size_t& index) {
+    Queue& queue = *queues_[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.front == queue.back) {
+        return false;
+    }
+    index = queue.front++;
+    return true;
+}
+
+inline bool btree_thread_pool::steal(size_t self, size_t& index) {
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        Queue& queue = *queues_[(self + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.front != queue.back) {
+            index = --queue.back;
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
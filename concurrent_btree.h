@@ -0,0 +1,474 @@
+#ifndef CONCURRENT_BTREE_H
+#define CONCURRENT_BTREE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * A B-Tree set that any number of threads can search while inserts go on,
+ * without the readers ever taking a lock.
+ *
+ * Every node carries a version counter which is odd while a writer is
+ * changing the node. A reader notes a node's version before looking at
+ * it and checks it again before trusting anything it read there, the
+ * pointer to the child it moves on to included. If the version has moved
+ * on, the reader starts again from the root. Keys, sizes and child
+ * pointers are atomics read with relaxed loads, so a reader racing a
+ * writer may see a half-updated node but never a torn value, and it
+ * throws away what it saw anyway. That is why T has to be trivially
+ * copyable.
+ *
+ * Writers take turns on a mutex, then mark as changing only the nodes the
+ * insert rewrites: the leaf, every full ancestor a split climbs through,
+ * and the ancestor that takes the last separator. Readers anywhere else
+ * in the tree are not held up at all.
+ *
+ * Nodes are never freed while the tree is alive, so a reader holding a
+ * stale pointer still lands in a node, just one whose version tells it
+ * to restart. There is no erase for that reason: freeing merged nodes
+ * would need a way, such as epochs, to know no reader is still in them.
+ */
+template <typename T, typename Compare = std::less<T>>
+class concurrent_btree {
+    static_assert(std::is_trivially_copyable<T>::value
+                , "concurrent_btree readers copy keys that may be "
+                  "overwritten under them, T must be trivially copyable");
+public:
+    /**
+     * @param maxNodeElems the maximum number of elements in a node, at
+     *        least 2
+     * @param comp the strict weak ordering of the elements
+     */
+    explicit concurrent_btree(size_t maxNodeElems = 40
+                            , const Compare& comp = Compare());
+    ~concurrent_btree();
+
+    concurrent_btree(const concurrent_btree&) = delete;
+    concurrent_btree& operator=(const concurrent_btree&) = delete;
+
+    /**
+     * Adds elem unless a matching element is already there. Any thread
+     * may call it; concurrent inserts are applied one after the other.
+     *
+     * @return true if elem was added
+     */
+    bool insert(const T& elem);
+
+    /**
+     * Looks elem up without locking anything. The answer holds for some
+     * moment during the call: an element inserted while it runs may or
+     * may not be seen, one inserted before it started always is.
+     *
+     * @return a copy of the matching element, or nothing
+     */
+    std::optional<T> find(const T& elem) const;
+    bool contains(const T& elem) const;
+
+    /**
+     * The number of elements, as of the last insert to finish.
+     */
+    size_t size() const;
+
+private:
+    struct Node {
+        Node(bool leaf);
+
+        std::atomic<uint64_t> version;
+        std::atomic<unsigned int> size;
+        const bool leaf;
+    };
+    typedef std::atomic<T> Key;
+    typedef std::atomic<Node*> Child;
+    typedef std::vector<std::pair<Node*, size_t>> Path;
+
+    static size_t keysOffset();
+    static size_t childrenOffset(size_t capacity);
+    static Key* keys(const Node *node);
+    Child* children(const Node *node) const;
+
+    Node* createNode(bool leaf);
+    void destroyTree(Node *node);
+
+    static uint64_t stableVersion(const Node *node);
+    static bool unchanged(const Node *node, uint64_t version);
+    static void lock(Node *node);
+    static void unlock(Node *node);
+
+    size_t search(const Node *node, const T& elem, bool& found) const;
+    bool tryFind(const T& elem, std::optional<T>& match) const;
+    void addElement(Node *node, size_t slot, const T& elem, Node *rightChild);
+    T split(Node *node, size_t slot, const T& elem, Node *rightChild
+          , Node *&sibling);
+
+    std::atomic<Node*> root_;
+    std::atomic<size_t> size_;
+    size_t maxNodeElems_;
+    Compare comp_;
+    std::mutex writer_;
+};
+
+// concurrent_btree
+template <typename T, typename Compare>
+concurrent_btree<T, Compare>::Node::Node(bool leaf)
+    : version{0}
+    , size{0}
+    , leaf{leaf} {
+}
+
+template <typename T, typename Compare>
+concurrent_btree<T, Compare>::concurrent_btree(size_t maxNodeElems
+                                             , const Compare& comp)
+    : root_{nullptr}
+    , size_{0}
+    , maxNodeElems_{std::max<size_t>(maxNodeElems, 2)}
+    , comp_{comp}
+    , writer_{} {
+    // an empty leaf to start with spares readers a null check
+    root_.store(createNode(true), std::memory_order_release);
+}
+
+template <typename T, typename Compare>
+concurrent_btree<T, Compare>::~concurrent_btree() {
+    destroyTree(root_.load(std::memory_order_relaxed));
+}
+
+template <typename T, typename Compare>
+size_t concurrent_btree<T, Compare>::keysOffset() {
+    return (sizeof(Node) + alignof(Key) - 1) / alignof(Key) * alignof(Key);
+}
+
+template <typename T, typename Compare>
+size_t concurrent_btree<T, Compare>::childrenOffset(size_t capacity) {
+    size_t end = keysOffset() + capacity * sizeof(Key);
+    return (end + alignof(Child) - 1) / alignof(Child) * alignof(Child);
+}
+
+template <typename T, typename Compare>
+typename concurrent_btree<T, Compare>::Key*
+concurrent_btree<T, Compare>::keys(const Node *node) {
+    return reinterpret_cast<Key*>(
+            reinterpret_cast<char*>(const_cast<Node*>(node)) + keysOffset());
+}
+
+template <typename T, typename Compare>
+typename concurrent_btree<T, Compare>::Child*
+concurrent_btree<T, Compare>::children(const Node *node) const {
+    return reinterpret_cast<Child*>(
+            reinterpret_cast<char*>(const_cast<Node*>(node))
+            + childrenOffset(maxNodeElems_));
+}
+
+/**
+ * Nodes are laid out like btree_node: header, keys, and child pointers
+ * for internal nodes. Every slot is constructed up front, so a reader
+ * that strays past a node's size still reads a live atomic.
+ */
+template <typename T, typename Compare>
+typename concurrent_btree<T, Compare>::Node*
+concurrent_btree<T, Compare>::createNode(bool leaf) {
+    size_t bytes = leaf ? keysOffset() + maxNodeElems_ * sizeof(Key)
+                        : childrenOffset(maxNodeElems_)
+                              + (maxNodeElems_ + 1) * sizeof(Child);
+    Node *node = new (::operator new(bytes)) Node(leaf);
+    for (size_t i = 0; i < maxNodeElems_; ++i) {
+        new (keys(node) + i) Key(T());
+    }
+    for (size_t i = 0; !leaf && i <= maxNodeElems_; ++i) {
+        new (children(node) + i) Child(nullptr);
+    }
+    return node;
+}
+
+template <typename T, typename Compare>
+void concurrent_btree<T, Compare>::destroyTree(Node *node) {
+    size_t size = node->size.load(std::memory_order_relaxed);
+    for (size_t i = 0; !node->leaf && i <= size; ++i) {
+        destroyTree(children(node)[i].load(std::memory_order_relaxed));
+    }
+    node->~Node();
+    ::operator delete(node);
+}
+
+/**
+ * The node's version once no writer is in the middle of changing it.
+ */
+template <typename T, typename Compare>
+uint64_t concurrent_btree<T, Compare>::stableVersion(const Node *node) {
+    uint64_t version = node->version.load(std::memory_order_acquire);
+    while (version & 1) {
+        std::this_thread::yield();
+        version = node->version.load(std::memory_order_acquire);
+    }
+    return version;
+}
+
+/**
+ * True if nothing read from node since its version was taken can have
+ * been changed by a writer.
+ */
+template <typename T, typename Compare>
+bool concurrent_btree<T, Compare>::unchanged(const Node *node
+                                           , uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return node->version.load(std::memory_order_relaxed) == version;
+}
+
+template <typename T, typename Compare>
+void concurrent_btree<T, Compare>::lock(Node *node) {
+    uint64_t version = node->version.load(std::memory_order_relaxed);
+    node->version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <typename T, typename Compare>
+void concurrent_btree<T, Compare>::unlock(Node *node) {
+    uint64_t version = node->version.load(std::memory_order_relaxed);
+    node->version.store(version + 1, std::memory_order_release);
+}
+
+/**
+ * The first slot whose key is not less than elem. The size is clamped to
+ * the capacity so that a reader working from a stale size stays inside
+ * the node.
+ */
+template <typename T, typename Compare>
+size_t concurrent_btree<T, Compare>::search(const Node *node, const T& elem
+                                          , bool& found) const {
+    const Key *keys = this->keys(node);
+    size_t size = std::min<size_t>(node->size.load(std::memory_order_relaxed)
+                                 , maxNodeElems_);
+    size_t lo = 0;
+    size_t hi = size;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (comp_(keys[mid].load(std::memory_order_relaxed), elem)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    found = lo < size && !comp_(elem, keys[lo].load(std::memory_order_relaxed));
+    return lo;
+}
+
+template <typename T, typename Compare>
+std::optional<T> concurrent_btree<T, Compare>::find(const T& elem) const {
+    std::optional<T> match;
+    while (!tryFind(elem, match)) {
+    }
+    return match;
+}
+
+template <typename T, typename Compare>
+bool concurrent_btree<T, Compare>::contains(const T& elem) const {
+    return find(elem).has_value();
+}
+
+/**
+ * One attempt at a lookup, false if a writer got in the way. The child's
+ * version is taken before the parent is checked again: if the parent
+ * hasn't changed by then, the pointer was still current when the child's
+ * version was read, and whatever happens to the child afterwards shows
+ * up in that version.
+ */
+template <typename T, typename Compare>
+bool concurrent_btree<T, Compare>::tryFind(const T& elem
+                                         , std::optional<T>& match) const {
+    Node *node = root_.load(std::memory_order_acquire);
+    uint64_t version = stableVersion(node);
+
+    // a root that split after we loaded it only holds half the tree
+    if (root_.load(std::memory_order_acquire) != node) {
+        return false;
+    }
+    while (true) {
+        bool found = false;
+        size_t i = search(node, elem, found);
+        if (found) {
+            T key = keys(node)[i].load(std::memory_order_relaxed);
+            if (!unchanged(node, version)) {
+                return false;
+            }
+            match = key;
+            return true;
+        }
+        if (node->leaf) {
+            if (!unchanged(node, version)) {
+                return false;
+            }
+            match.reset();
+            return true;
+        }
+        Node *child = children(node)[i].load(std::memory_order_acquire);
+        if (child == nullptr) {
+            return false;
+        }
+        uint64_t childVersion = stableVersion(child);
+        if (!unchanged(node, version)) {
+            return false;
+        }
+        node = child;
+        version = childVersion;
+    }
+}
+
+template <typename T, typename Compare>
+size_t concurrent_btree<T, Compare>::size() const {
+    return size_.load(std::memory_order_relaxed);
+}
+
+/**
+ * Works out up front which nodes the insert is going to rewrite and marks
+ * them all before touching any, keeping them marked until the last one is
+ * done: a reader must not see a child already split while its parent
+ * still sends it there for the keys that moved out.
+ */
+template <typename T, typename Compare>
+bool concurrent_btree<T, Compare>::insert(const T& elem) {
+    std::lock_guard<std::mutex> guard(writer_);
+
+    // nothing else writes, so the writer can read without checking
+    Path path;
+    Node *node = root_.load(std::memory_order_relaxed);
+    while (true) {
+        bool found = false;
+        size_t i = search(node, elem, found);
+        if (found) {
+            return false;
+        }
+        path.emplace_back(node, i);
+        if (node->leaf) {
+            break;
+        }
+        node = children(node)[i].load(std::memory_order_relaxed);
+    }
+
+    size_t top = path.size() - 1;
+    while (top > 0
+            && path[top].first->size.load(std::memory_order_relaxed)
+                == maxNodeElems_) {
+        --top;
+    }
+    for (size_t depth = top; depth < path.size(); ++depth) {
+        lock(path[depth].first);
+    }
+
+    T promoted = elem;
+    Node *rightChild = nullptr;
+    for (size_t depth = path.size(); depth-- > top; ) {
+        Node *node = path[depth].first;
+        size_t slot = path[depth].second;
+        if (node->size.load(std::memory_order_relaxed) < maxNodeElems_) {
+            addElement(node, slot, promoted, rightChild);
+            rightChild = nullptr;
+            break;
+        }
+        Node *sibling = nullptr;
+        promoted = split(node, slot, promoted, rightChild, sibling);
+        rightChild = sibling;
+    }
+    if (rightChild != nullptr) {
+        // the new root goes in before the old one is unlocked, see tryFind
+        Node *root = createNode(false);
+        keys(root)[0].store(promoted, std::memory_order_relaxed);
+        children(root)[0].store(path[0].first, std::memory_order_relaxed);
+        children(root)[1].store(rightChild, std::memory_order_relaxed);
+        root->size.store(1, std::memory_order_relaxed);
+        root_.store(root, std::memory_order_release);
+    }
+
+    for (size_t depth = top; depth < path.size(); ++depth) {
+        unlock(path[depth].first);
+    }
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * Puts elem at slot in a node with room for it, and rightChild after it.
+ * Child pointers are stored with release so that a reader following one
+ * to a freshly split off node sees the node's contents.
+ */
+template <typename T, typename Compare>
+void concurrent_btree<T, Compare>::addElement(Node *node, size_t slot
+                                            , const T& elem
+                                            , Node *rightChild) {
+    Key *keys = this->keys(node);
+    size_t size = node->size.load(std::memory_order_relaxed);
+    for (size_t i = size; i > slot; --i) {
+        keys[i].store(keys[i - 1].load(std::memory_order_relaxed)
+                    , std::memory_order_relaxed);
+    }
+    keys[slot].store(elem, std::memory_order_relaxed);
+    if (!node->leaf) {
+        Child *children = this->children(node);
+        for (size_t i = size + 1; i > slot + 1; --i) {
+            children[i].store(children[i - 1].load(std::memory_order_relaxed)
+                            , std::memory_order_release);
+        }
+        children[slot + 1].store(rightChild, std::memory_order_release);
+    }
+    node->size.store(size + 1, std::memory_order_relaxed);
+}
+
+/**
+ * Splits the full node while adding elem (and rightChild after it) at
+ * slot. The node keeps the lower half, a new sibling gets the upper half,
+ * and the key between them is returned for the parent. The sibling is
+ * unreachable until the parent takes it in.
+ */
+template <typename T, typename Compare>
+T concurrent_btree<T, Compare>::split(Node *node, size_t slot, const T& elem
+                                    , Node *rightChild, Node *&sibling) {
+    Key *keys = this->keys(node);
+    std::vector<T> allKeys;
+    allKeys.reserve(maxNodeElems_ + 1);
+    for (size_t i = 0; i < maxNodeElems_; ++i) {
+        allKeys.push_back(keys[i].load(std::memory_order_relaxed));
+    }
+    allKeys.insert(allKeys.begin() + slot, elem);
+    std::vector<Node*> allChildren;
+    if (!node->leaf) {
+        Child *children = this->children(node);
+        for (size_t i = 0; i <= maxNodeElems_; ++i) {
+            allChildren.push_back(children[i].load(std::memory_order_relaxed));
+        }
+        allChildren.insert(allChildren.begin() + slot + 1, rightChild);
+    }
+
+    size_t half = (maxNodeElems_ + 1) / 2;
+    sibling = createNode(node->leaf);
+    Key *siblingKeys = this->keys(sibling);
+    for (size_t i = 0; i < half; ++i) {
+        keys[i].store(allKeys[i], std::memory_order_relaxed);
+    }
+    for (size_t i = half + 1; i < allKeys.size(); ++i) {
+        siblingKeys[i - half - 1].store(allKeys[i], std::memory_order_relaxed);
+    }
+    if (!node->leaf) {
+        Child *children = this->children(node);
+        Child *siblingChildren = this->children(sibling);
+        for (size_t i = 0; i <= half; ++i) {
+            children[i].store(allChildren[i], std::memory_order_release);
+        }
+        for (size_t i = half + 1; i < allChildren.size(); ++i) {
+            siblingChildren[i - half - 1].store(allChildren[i]
+                                              , std::memory_order_relaxed);
+        }
+    }
+    node->size.store(half, std::memory_order_relaxed);
+    sibling->size.store(allKeys.size() - half - 1, std::memory_order_relaxed);
+    return allKeys[half];
+}
+
+#endif
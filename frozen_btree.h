@@ -0,0 +1,286 @@
+#ifndef FROZEN_BTREE_H
+#define FROZEN_BTREE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "btree_search.h"
+
+const size_t kFrozenBlockKeys = 16;
+
+/**
+ * An immutable set laid out for lookups, as btree::freeze makes it: an
+ * implicit B+ tree with no child pointers at all. The elements are kept
+ * in order in one array, which is the leaf level, so iterating is a walk
+ * along it. Above them sit levels of separator blocks, the root's first,
+ * where a block's children are found by arithmetic on its position: the
+ * children of block k are blocks k * 17 to k * 17 + 16 of the level
+ * below, and leaf block k is elements k * 16 to k * 16 + 15.
+ *
+ * Each block holds kFrozenBlockKeys keys, a cache line of ints or two of
+ * longs. Blocks of numbers are searched with btree_lower_bound_fixed,
+ * whose steps don't depend on the keys, so a lookup is a fixed number of
+ * steps for each level with no branches to mispredict. Other keys, whose
+ * comparisons follow pointers, take an ordinary binary search instead:
+ * there the processor guessing ahead overlaps the loads, which a chain
+ * of branch-free steps would make it wait out one by one. The separators
+ * add about one key in sixteen to the elements themselves.
+ *
+ * T must be default constructible, as the last block of a level may not
+ * be full. comp must order the elements as the btree they came from did.
+ */
+template <typename T, typename Compare = std::less<T>>
+class frozen_btree {
+public:
+    typedef typename std::vector<T>::const_iterator const_iterator;
+    typedef const_iterator iterator;
+    typedef Compare key_compare;
+
+    explicit frozen_btree(const Compare& comp = Compare());
+
+    /**
+     * Lays out the elements of [first, last), which must already be in
+     * order under comp and hold no repeats, as a btree hands them out.
+     */
+    template <typename ForwardIt>
+    frozen_btree(ForwardIt first, ForwardIt last
+               , const Compare& comp = Compare());
+
+    size_t size() const;
+    bool empty() const;
+
+    /**
+     * The levels of separator blocks above the elements.
+     */
+    size_t height() const;
+
+    /**
+     * The bytes the elements and separators take up, not counting memory
+     * the keys themselves own, such as a long std::string's buffer.
+     */
+    size_t bytes() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     * The first element not less than elem, or end() if there is none.
+     */
+    const_iterator lower_bound(const T& elem) const;
+
+    /**
+     * The matching element, or end() if there is none.
+     */
+    const_iterator find(const T& elem) const;
+    bool contains(const T& elem) const;
+
+    template <typename K, typename C = Compare
+            , typename = typename C::is_transparent>
+    const_iterator lower_bound(const K& elem) const;
+    template <typename K, typename C = Compare
+            , typename = typename C::is_transparent>
+    const_iterator find(const K& elem) const;
+    template <typename K, typename C = Compare
+            , typename = typename C::is_transparent>
+    bool contains(const K& elem) const;
+
+private:
+    // a level of separator blocks: where its first block starts in
+    // separators_, in blocks, and how many blocks the level below has
+    struct Level {
+        size_t offset;
+        size_t children;
+    };
+
+    template <typename K>
+    size_t lowerBound(const K& elem) const;
+    template <typename K>
+    size_t searchBlock(const T *keys, size_t size, const K& elem) const;
+    template <typename K>
+    const_iterator findKey(const K& elem) const;
+
+    std::vector<T> keys_;
+    std::vector<T> separators_;
+    std::vector<Level> levels_;
+    Compare comp_;
+};
+
+// frozen_btree
+template <typename T, typename Compare>
+frozen_btree<T, Compare>::frozen_btree(const Compare& comp)
+    : keys_{}
+    , separators_{}
+    , levels_{}
+    , comp_{comp} {
+}
+
+/**
+ * Sizes the levels from the bottom up, each with a block for every 17
+ * blocks below it, until one block is left. The separators of a block
+ * are the first elements under each of its children but the first.
+ */
+template <typename T, typename Compare>
+template <typename ForwardIt>
+frozen_btree<T, Compare>::frozen_btree(ForwardIt first, ForwardIt last
+                                     , const Compare& comp)
+    : keys_(first, last)
+    , separators_{}
+    , levels_{}
+    , comp_{comp} {
+    const size_t fanout = kFrozenBlockKeys + 1;
+    std::vector<size_t> blocks;
+    size_t below = (keys_.size() + kFrozenBlockKeys - 1) / kFrozenBlockKeys;
+    while (below > 1) {
+        levels_.push_back(Level{0, below});
+        below = (below + fanout - 1) / fanout;
+        blocks.push_back(below);
+    }
+    std::reverse(levels_.begin(), levels_.end());
+    std::reverse(blocks.begin(), blocks.end());
+
+    size_t offset = 0;
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        levels_[level].offset = offset;
+        offset += blocks[level];
+    }
+    separators_.resize(offset * kFrozenBlockKeys);
+
+    // the elements under one child of a block on the lowest level
+    size_t span = kFrozenBlockKeys;
+    for (size_t level = levels_.size(); level-- > 0; ) {
+        const Level& at = levels_[level];
+        for (size_t block = 0; block < blocks[level]; ++block) {
+            T *separators = separators_.data()
+                          + (at.offset + block) * kFrozenBlockKeys;
+            for (size_t i = 0; i < kFrozenBlockKeys; ++i) {
+                size_t child = block * fanout + i + 1;
+                if (child < at.children) {
+                    separators[i] = keys_[child * span];
+                }
+            }
+        }
+        span *= fanout;
+    }
+}
+
+template <typename T, typename Compare>
+size_t frozen_btree<T, Compare>::size() const {
+    return keys_.size();
+}
+
+template <typename T, typename Compare>
+bool frozen_btree<T, Compare>::empty() const {
+    return keys_.empty();
+}
+
+template <typename T, typename Compare>
+size_t frozen_btree<T, Compare>::height() const {
+    return levels_.size();
+}
+
+template <typename T, typename Compare>
+size_t frozen_btree<T, Compare>::bytes() const {
+    return (keys_.capacity() + separators_.capacity()) * sizeof(T)
+         + levels_.capacity() * sizeof(Level);
+}
+
+template <typename T, typename Compare>
+typename frozen_btree<T, Compare>::const_iterator
+frozen_btree<T, Compare>::begin() const {
+    return keys_.cbegin();
+}
+
+template <typename T, typename Compare>
+typename frozen_btree<T, Compare>::const_iterator
+frozen_btree<T, Compare>::end() const {
+    return keys_.cend();
+}
+
+template <typename T, typename Compare>
+typename frozen_btree<T, Compare>::const_iterator
+frozen_btree<T, Compare>::lower_bound(const T& elem) const {
+    return keys_.cbegin() + lowerBound(elem);
+}
+
+template <typename T, typename Compare>
+typename frozen_btree<T, Compare>::const_iterator
+frozen_btree<T, Compare>::find(const T& elem) const {
+    return findKey(elem);
+}
+
+template <typename T, typename Compare>
+bool frozen_btree<T, Compare>::contains(const T& elem) const {
+    return findKey(elem) != keys_.cend();
+}
+
+template <typename T, typename Compare>
+template <typename K, typename C, typename>
+typename frozen_btree<T, Compare>::const_iterator
+frozen_btree<T, Compare>::lower_bound(const K& elem) const {
+    return keys_.cbegin() + lowerBound(elem);
+}
+
+template <typename T, typename Compare>
+template <typename K, typename C, typename>
+typename frozen_btree<T, Compare>::const_iterator
+frozen_btree<T, Compare>::find(const K& elem) const {
+    return findKey(elem);
+}
+
+template <typename T, typename Compare>
+template <typename K, typename C, typename>
+bool frozen_btree<T, Compare>::contains(const K& elem) const {
+    return findKey(elem) != keys_.cend();
+}
+
+/**
+ * Picks a child on every level by where elem falls among the block's
+ * separators, then elem's place within the leaf block. Should every
+ * element of that leaf block be less than elem, the answer is the first
+ * element of the next, which is just past them in keys_.
+ */
+template <typename T, typename Compare>
+template <typename K>
+size_t frozen_btree<T, Compare>::lowerBound(const K& elem) const {
+    const size_t fanout = kFrozenBlockKeys + 1;
+    size_t block = 0;
+    for (const Level& level : levels_) {
+        size_t first = block * fanout;
+        size_t size = std::min(fanout, level.children - first) - 1;
+        const T *separators = separators_.data()
+                            + (level.offset + block) * kFrozenBlockKeys;
+        block = first + searchBlock(separators, size, elem);
+    }
+    size_t first = block * kFrozenBlockKeys;
+    size_t size = std::min(kFrozenBlockKeys, keys_.size() - first);
+    return first + searchBlock(keys_.data() + first, size, elem);
+}
+
+template <typename T, typename Compare>
+template <typename K>
+size_t frozen_btree<T, Compare>::searchBlock(const T *keys, size_t size
+                                           , const K& elem) const {
+    if constexpr (std::is_arithmetic<T>::value) {
+        return btree_lower_bound_fixed<kFrozenBlockKeys>(keys, size, elem
+                                                       , comp_);
+    } else {
+        return std::lower_bound(keys, keys + size, elem, comp_) - keys;
+    }
+}
+
+template <typename T, typename Compare>
+template <typename K>
+typename frozen_btree<T, Compare>::const_iterator
+frozen_btree<T, Compare>::findKey(const K& elem) const {
+    const_iterator iter = keys_.cbegin() + lowerBound(elem);
+    if (iter != keys_.cend() && comp_(elem, *iter)) {
+        return keys_.cend();
+    }
+    return iter;
+}
+
+#endif
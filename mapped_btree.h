@@ -0,0 +1,445 @@
+#ifndef MAPPED_BTREE_H
+#define MAPPED_BTREE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "btree_file.h"
+
+/**
+ * A read-only btree served straight out of a file written by
+ * btree::save. Opening it maps the file and checks its header, in O(1)
+ * whatever the size of the tree: nothing is read in, copied or rebuilt.
+ * Lookups and iteration read the node pages where they lie in the
+ * mapping, so pages are only read from disk as they are first touched,
+ * and processes mapping the same file share one copy of it in the page
+ * cache.
+ *
+ * Elements come back as references into the mapping, or as string_views
+ * of it for a tree of strings, valid for as long as the mapped_btree is
+ * open. comp must order the elements the way the saved btree did; the
+ * default compares whatever it is given with operator<, so lookups can
+ * use any type that compares with the elements.
+ *
+ * Only the header is checked on opening, which keeps it O(1). Every node
+ * read after that is checked as it is read: a key count is held to the
+ * node's capacity, a child must come before its parent in the file, and
+ * a string must lie within the key data. A damaged file can then give
+ * wrong answers, but never makes a lookup read outside the mapping or
+ * loop forever. verify() checks every node up front.
+ */
+template <typename T, typename Compare = std::less<>>
+class mapped_btree {
+    typedef btree_file_key<T> Key;
+    typedef typename Key::stored Stored;
+
+public:
+    typedef typename Key::reference reference;
+    class const_iterator;
+
+    /**
+     * Maps the file at path. If it can't be opened, or isn't a saved
+     * btree of this version with keys like T, the mapped_btree is left
+     * closed and empty.
+     */
+    explicit mapped_btree(const std::string& path
+                        , const Compare& comp = Compare());
+    ~mapped_btree();
+
+    mapped_btree(const mapped_btree&) = delete;
+    mapped_btree& operator=(const mapped_btree&) = delete;
+
+    bool is_open() const;
+
+    /**
+     * Reads every node, in O(n), and checks it the way lookups check the
+     * nodes they reach, and that the key counts add up to size().
+     *
+     * @return true if the file is open and every node is sound
+     */
+    bool verify() const;
+
+    size_t size() const;
+    bool empty() const;
+    size_t height() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     * The first element not less than elem, or end() if there is none.
+     */
+    template <typename K>
+    const_iterator lower_bound(const K& elem) const;
+
+    /**
+     * The matching element, or end() if there is none.
+     */
+    template <typename K>
+    const_iterator find(const K& elem) const;
+
+    template <typename K>
+    bool contains(const K& elem) const;
+
+private:
+    typedef std::vector<std::pair<const char*, size_t>> Path;
+
+    const char* page(uint64_t index) const;
+    size_t sizeOf(const char *node) const;
+    static bool isLeaf(const char *node);
+    reference key(const char *node, size_t i) const;
+    const char* child(const char *node, size_t i) const;
+    template <typename K>
+    size_t lowerBound(const char *node, const K& elem) const;
+    bool descendLeft(Path& path, const char *node) const;
+    void climb(Path& path) const;
+
+    const char *base_;
+    size_t bytes_;
+    btree_file_header header_;
+    size_t childrenOffset_;
+    Compare comp_;
+};
+
+/**
+ * Walks the elements in order, keeping the way down from the root to the
+ * current element as btree_iterator does.
+ */
+template <typename T, typename Compare>
+class mapped_btree<T, Compare>::const_iterator {
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef std::ptrdiff_t difference_type;
+    typedef typename Key::reference reference;
+    typedef std::remove_cv_t<std::remove_reference_t<reference>> value_type;
+    typedef const value_type* pointer;
+
+    reference operator*() const;
+    const_iterator& operator++();
+    const_iterator operator++(int);
+    bool operator==(const const_iterator& other) const;
+    bool operator!=(const const_iterator& other) const;
+
+private:
+    friend class mapped_btree;
+
+    const_iterator(const mapped_btree *tree, Path path);
+
+    const mapped_btree *tree_;
+    Path path_;
+};
+
+// mapped_btree
+template <typename T, typename Compare>
+mapped_btree<T, Compare>::mapped_btree(const std::string& path
+                                     , const Compare& comp)
+    : base_{nullptr}
+    , bytes_{0}
+    , header_{}
+    , childrenOffset_{0}
+    , comp_{comp} {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat status;
+    if (::fstat(fd, &status) == 0
+            && static_cast<size_t>(status.st_size) >= kBtreeFilePage) {
+        void *mem = ::mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mem != MAP_FAILED) {
+            base_ = static_cast<const char*>(mem);
+            bytes_ = status.st_size;
+        }
+    }
+    ::close(fd);
+    if (base_ == nullptr) {
+        return;
+    }
+
+    std::memcpy(&header_, base_, sizeof(header_));
+    if (!btree_file_check(header_, Key::kind, sizeof(Stored), alignof(Stored)
+                        , bytes_)) {
+        ::munmap(const_cast<char*>(base_), bytes_);
+        base_ = nullptr;
+        bytes_ = 0;
+        header_ = btree_file_header{};
+        return;
+    }
+    childrenOffset_ = btree_file_children_offset(header_);
+}
+
+template <typename T, typename Compare>
+mapped_btree<T, Compare>::~mapped_btree() {
+    if (base_ != nullptr) {
+        ::munmap(const_cast<char*>(base_), bytes_);
+    }
+}
+
+template <typename T, typename Compare>
+bool mapped_btree<T, Compare>::is_open() const {
+    return base_ != nullptr;
+}
+
+template <typename T, typename Compare>
+bool mapped_btree<T, Compare>::verify() const {
+    if (base_ == nullptr) {
+        return false;
+    }
+    uint64_t elems = 0;
+    for (uint64_t index = 0; index < header_.nodes; ++index) {
+        const char *node = page(index);
+        uint32_t words[2];
+        std::memcpy(words, node, sizeof(words));
+        bool leaf = words[1] != 0;
+        if (words[1] > 1
+                || words[0] > (leaf ? header_.leafKeys : header_.nodeKeys)) {
+            return false;
+        }
+        const Stored *keys = reinterpret_cast<const Stored*>(
+                node + header_.keyOffset);
+        for (size_t i = 0; i < words[0]; ++i) {
+            if (!Key::fits(keys[i], header_.dataBytes)) {
+                return false;
+            }
+        }
+        for (size_t i = 0; !leaf && i <= words[0]; ++i) {
+            if (child(node, i) == nullptr) {
+                return false;
+            }
+        }
+        elems += words[0];
+    }
+    return elems == header_.elems;
+}
+
+template <typename T, typename Compare>
+size_t mapped_btree<T, Compare>::size() const {
+    return header_.elems;
+}
+
+template <typename T, typename Compare>
+bool mapped_btree<T, Compare>::empty() const {
+    return header_.elems == 0;
+}
+
+template <typename T, typename Compare>
+size_t mapped_btree<T, Compare>::height() const {
+    return header_.height;
+}
+
+template <typename T, typename Compare>
+typename mapped_btree<T, Compare>::const_iterator
+mapped_btree<T, Compare>::begin() const {
+    Path path;
+    if (header_.elems > 0 && !descendLeft(path, page(header_.root))) {
+        path.clear();
+    }
+    return const_iterator(this, std::move(path));
+}
+
+template <typename T, typename Compare>
+typename mapped_btree<T, Compare>::const_iterator
+mapped_btree<T, Compare>::end() const {
+    return const_iterator(this, Path());
+}
+
+/**
+ * Stops at the first node holding elem; otherwise the leaf slot it would
+ * go in, which if past the leaf's last key is moved up to the separator
+ * after it.
+ */
+template <typename T, typename Compare>
+template <typename K>
+typename mapped_btree<T, Compare>::const_iterator
+mapped_btree<T, Compare>::lower_bound(const K& elem) const {
+    Path path;
+    if (header_.elems == 0) {
+        return end();
+    }
+    for (const char *node = page(header_.root); ; ) {
+        size_t i = lowerBound(node, elem);
+        path.emplace_back(node, i);
+        if (i < sizeOf(node) && !comp_(elem, key(node, i))) {
+            break;
+        }
+        if (isLeaf(node)) {
+            climb(path);
+            break;
+        }
+        node = child(node, i);
+        if (node == nullptr) {
+            return end();
+        }
+    }
+    return const_iterator(this, std::move(path));
+}
+
+template <typename T, typename Compare>
+template <typename K>
+typename mapped_btree<T, Compare>::const_iterator
+mapped_btree<T, Compare>::find(const K& elem) const {
+    const_iterator iter = lower_bound(elem);
+    if (iter != end() && comp_(elem, *iter)) {
+        return end();
+    }
+    return iter;
+}
+
+template <typename T, typename Compare>
+template <typename K>
+bool mapped_btree<T, Compare>::contains(const K& elem) const {
+    return find(elem) != end();
+}
+
+template <typename T, typename Compare>
+const char* mapped_btree<T, Compare>::page(uint64_t index) const {
+    return base_ + (index + 1) * header_.pageBytes;
+}
+
+template <typename T, typename Compare>
+size_t mapped_btree<T, Compare>::sizeOf(const char *node) const {
+    uint32_t size;
+    std::memcpy(&size, node, sizeof(size));
+    return std::min<size_t>(size, isLeaf(node) ? header_.leafKeys
+                                               : header_.nodeKeys);
+}
+
+template <typename T, typename Compare>
+bool mapped_btree<T, Compare>::isLeaf(const char *node) {
+    uint32_t leaf;
+    std::memcpy(&leaf, node + sizeof(uint32_t), sizeof(leaf));
+    return leaf != 0;
+}
+
+template <typename T, typename Compare>
+typename mapped_btree<T, Compare>::reference
+mapped_btree<T, Compare>::key(const char *node, size_t i) const {
+    const Stored *keys = reinterpret_cast<const Stored*>(
+            node + header_.keyOffset);
+    return Key::view(keys[i], base_ + header_.dataOffset, header_.dataBytes);
+}
+
+/**
+ * Nodes are written children first, so a child index that isn't below
+ * the node's own is damage; it comes back as nullptr.
+ */
+template <typename T, typename Compare>
+const char* mapped_btree<T, Compare>::child(const char *node, size_t i) const {
+    const uint32_t *children = reinterpret_cast<const uint32_t*>(
+            node + childrenOffset_);
+    size_t index = (node - base_) / header_.pageBytes - 1;
+    return children[i] < index ? page(children[i]) : nullptr;
+}
+
+template <typename T, typename Compare>
+template <typename K>
+size_t mapped_btree<T, Compare>::lowerBound(const char *node
+                                          , const K& elem) const {
+    size_t lo = 0;
+    size_t hi = sizeOf(node);
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (comp_(key(node, mid), elem)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * Returns false, part way down, on reaching a damaged child index.
+ */
+template <typename T, typename Compare>
+bool mapped_btree<T, Compare>::descendLeft(Path& path, const char *node) const {
+    while (!isLeaf(node)) {
+        path.emplace_back(node, 0);
+        node = child(node, 0);
+        if (node == nullptr) {
+            return false;
+        }
+    }
+    path.emplace_back(node, 0);
+    return true;
+}
+
+/**
+ * Moves a path left past the end of its node up to the next element:
+ * the separator to the right of the first child on the way back up that
+ * isn't its node's last. An empty path is end().
+ */
+template <typename T, typename Compare>
+void mapped_btree<T, Compare>::climb(Path& path) const {
+    while (!path.empty() && path.back().second == sizeOf(path.back().first)) {
+        path.pop_back();
+    }
+}
+
+// mapped_btree::const_iterator
+template <typename T, typename Compare>
+mapped_btree<T, Compare>::const_iterator::const_iterator(
+        const mapped_btree *tree, Path path)
+    : tree_{tree}
+    , path_{std::move(path)} {
+}
+
+template <typename T, typename Compare>
+typename mapped_btree<T, Compare>::reference
+mapped_btree<T, Compare>::const_iterator::operator*() const {
+    return tree_->key(path_.back().first, path_.back().second);
+}
+
+template <typename T, typename Compare>
+typename mapped_btree<T, Compare>::const_iterator&
+mapped_btree<T, Compare>::const_iterator::operator++() {
+    const char *node = path_.back().first;
+    size_t slot = ++path_.back().second;
+    if (isLeaf(node)) {
+        tree_->climb(path_);
+    } else {
+        const char *next = tree_->child(node, slot);
+        if (next == nullptr || !tree_->descendLeft(path_, next)) {
+            path_.clear();
+        }
+    }
+    return *this;
+}
+
+template <typename T, typename Compare>
+typename mapped_btree<T, Compare>::const_iterator
+mapped_btree<T, Compare>::const_iterator::operator++(int) {
+    const_iterator old = *this;
+    ++*this;
+    return old;
+}
+
+template <typename T, typename Compare>
+bool mapped_btree<T, Compare>::const_iterator::operator==(
+        const const_iterator& other) const {
+    if (path_.empty() || other.path_.empty()) {
+        return path_.empty() && other.path_.empty();
+    }
+    return path_.back() == other.path_.back();
+}
+
+template <typename T, typename Compare>
+bool mapped_btree<T, Compare>::const_iterator::operator!=(
+        const const_iterator& other) const {
+    return !(*this == other);
+}
+
+#endif
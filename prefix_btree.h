@@ -0,0 +1,496 @@
+#ifndef PREFIX_BTREE_H
+#define PREFIX_BTREE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * A read-only set of strings for dictionary workloads, with every node
+ * packed into one run of bytes: the prefix its keys all share, stored
+ * once, then just the rest of each key, end to end. A btree<std::string>
+ * gives every key a 32-byte std::string, and a heap buffer of its own
+ * once it is too long to fit inside one; here a key costs the bytes of
+ * its suffix and a 4-byte end offset, so many more of them fit in the
+ * cache lines a find touches.
+ *
+ * A search checks the node's prefix once and then compares only the
+ * suffixes. Keys are ordered byte by byte, as std::string's operator<
+ * orders them; the common prefix of a node's keys is that of its first
+ * and last.
+ *
+ * The whole tree lives in one byte buffer, nodes referring to their
+ * children by 32-bit offset into it, so it must come to under 4 GiB; a
+ * constructor given keys that would take more throws std::length_error.
+ * Copies and moves are those of the buffer. Elements are rebuilt from
+ * prefix and suffix as they are read, and come back as std::strings by
+ * value.
+ */
+class prefix_btree {
+public:
+    class const_iterator;
+
+    /**
+     * Builds the set from the strings of [first, last), bottom-up as
+     * btree::bulk_load does, with nodes filled up and the keys spread
+     * evenly between them.
+     *
+     * @param first, last the strings to hold, in any order; repeats are
+     *        kept once
+     * @param maxNodeElems the maximum number of keys in each node (at
+     *        least 2)
+     */
+    template <typename InputIt>
+    prefix_btree(InputIt first, InputIt last, size_t maxNodeElems = 40);
+
+    size_t size() const;
+    bool empty() const;
+    size_t height() const;
+
+    /**
+     * The bytes the nodes take up, all of them in one buffer.
+     */
+    size_t bytes() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     * The first key not less than elem, or end() if there is none.
+     */
+    const_iterator lower_bound(std::string_view elem) const;
+
+    /**
+     * The matching key, or end() if there is none.
+     */
+    const_iterator find(std::string_view elem) const;
+    bool contains(std::string_view elem) const;
+
+private:
+    typedef std::vector<std::pair<uint32_t, size_t>> Path;
+
+    // the words at the start of a node, before its end offsets
+    static const size_t kSize = 0;
+    static const size_t kLeaf = 1;
+    static const size_t kPrefix = 2;
+    static const size_t kHeaderWords = 3;
+
+    void build(std::vector<std::string> keys);
+    uint32_t writeNode(const std::string *const *keys, size_t size
+                     , const uint32_t *children);
+
+    uint32_t word(uint32_t node, size_t i) const;
+    size_t sizeOf(uint32_t node) const;
+    bool isLeaf(uint32_t node) const;
+    uint32_t child(uint32_t node, size_t i) const;
+    std::string_view prefix(uint32_t node) const;
+    std::string_view suffix(uint32_t node, size_t i) const;
+    std::string key(uint32_t node, size_t i) const;
+    size_t search(uint32_t node, std::string_view elem, bool& found) const;
+    void descendLeft(Path& path, uint32_t node) const;
+    void climb(Path& path) const;
+
+    std::vector<char> bytes_;
+    size_t maxNodeElems_;
+    size_t size_;
+    size_t height_;
+    uint32_t root_;
+};
+
+/**
+ * Walks the keys in order, keeping the way down from the root to the
+ * current key as btree_iterator does. Keys are rebuilt as they are read,
+ * so there is nothing to point or refer to: it is an input iterator,
+ * whose reference is a std::string by value and which has no ->.
+ */
+class prefix_btree::const_iterator {
+public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::string value_type;
+    typedef std::string reference;
+    typedef void pointer;
+
+    reference operator*() const;
+    const_iterator& operator++();
+    const_iterator operator++(int);
+    bool operator==(const const_iterator& other) const;
+    bool operator!=(const const_iterator& other) const;
+
+private:
+    friend class prefix_btree;
+
+    const_iterator(const prefix_btree *tree, Path path);
+
+    const prefix_btree *tree_;
+    Path path_;
+};
+
+// prefix_btree
+template <typename InputIt>
+prefix_btree::prefix_btree(InputIt first, InputIt last, size_t maxNodeElems)
+    : bytes_{}
+    , maxNodeElems_{std::max<size_t>(maxNodeElems, 2)}
+    , size_{0}
+    , height_{0}
+    , root_{0} {
+    std::vector<std::string> keys;
+    for (; first != last; ++first) {
+        keys.emplace_back(*first);
+    }
+    build(std::move(keys));
+}
+
+/**
+ * Leaves first, every leaf but the last followed by a separator for the
+ * level above, then each level over the one below until one node is
+ * left, as btree_file_write lays out its pages.
+ */
+inline void prefix_btree::build(std::vector<std::string> keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    size_ = keys.size();
+    if (size_ == 0) {
+        return;
+    }
+
+    std::vector<const std::string*> nodeKeys;
+    std::vector<const std::string*> separators;
+    std::vector<uint32_t> level;
+    size_t target = maxNodeElems_;
+    size_t leaves = (size_ + 1 + target) / (target + 1);
+    leaves = std::max<size_t>(1, std::min(leaves, (size_ + 1) / 2));
+    size_t leafElems = size_ - (leaves - 1);
+    size_t next = 0;
+    for (size_t i = 0; i < leaves; ++i) {
+        nodeKeys.clear();
+        size_t elems = leafElems / leaves + (i < leafElems % leaves);
+        for (size_t j = 0; j < elems; ++j) {
+            nodeKeys.push_back(&keys[next++]);
+        }
+        level.push_back(writeNode(nodeKeys.data(), elems, nullptr));
+        if (i + 1 < leaves) {
+            separators.push_back(&keys[next++]);
+        }
+    }
+    height_ = 1;
+
+    while (level.size() > 1) {
+        size_t children = level.size();
+        size_t parents = (children + target) / (target + 1);
+        parents = std::max<size_t>(1, std::min(parents, children / 2));
+        std::vector<uint32_t> above;
+        std::vector<const std::string*> aboveSeparators;
+        size_t at = 0;
+        for (size_t i = 0; i < parents; ++i) {
+            size_t group = children / parents + (i < children % parents);
+            above.push_back(writeNode(separators.data() + at, group - 1
+                                    , level.data() + at));
+            at += group;
+            if (i + 1 < parents) {
+                aboveSeparators.push_back(separators[at - 1]);
+            }
+        }
+        level.swap(above);
+        separators.swap(aboveSeparators);
+        ++height_;
+    }
+    root_ = level.front();
+    bytes_.shrink_to_fit();
+}
+
+/**
+ * Appends a node, 4-byte aligned: its header words, the end of each
+ * suffix, the children's offsets for an internal node, then the shared
+ * prefix and the suffixes. Returns its offset. Throws std::length_error
+ * if the buffer would grow past what a 32-bit offset can reach.
+ */
+inline uint32_t prefix_btree::writeNode(const std::string *const *keys
+                                      , size_t size
+                                      , const uint32_t *children) {
+    const std::string& first = *keys[0];
+    const std::string& last = *keys[size - 1];
+    size_t shared = std::mismatch(first.begin()
+                                , first.begin() + std::min(first.size()
+                                                         , last.size())
+                                , last.begin()).first - first.begin();
+
+    std::vector<uint32_t> words = {static_cast<uint32_t>(size)
+                                 , children == nullptr
+                                 , static_cast<uint32_t>(shared)};
+    size_t end = 0;
+    for (size_t i = 0; i < size; ++i) {
+        end += keys[i]->size() - shared;
+        words.push_back(static_cast<uint32_t>(end));
+    }
+    for (size_t i = 0; children != nullptr && i <= size; ++i) {
+        words.push_back(children[i]);
+    }
+
+    size_t offset = (bytes_.size() + alignof(uint32_t) - 1)
+                  / alignof(uint32_t) * alignof(uint32_t);
+    size_t nodeEnd = offset + words.size() * sizeof(uint32_t) + shared + end;
+    if (end > UINT32_MAX || nodeEnd > UINT32_MAX) {
+        throw std::length_error("prefix_btree: keys take 4 GiB or more");
+    }
+    bytes_.resize(nodeEnd);
+    char *at = bytes_.data() + offset;
+    std::memcpy(at, words.data(), words.size() * sizeof(uint32_t));
+    at += words.size() * sizeof(uint32_t);
+    std::memcpy(at, first.data(), shared);
+    at += shared;
+    for (size_t i = 0; i < size; ++i) {
+        std::memcpy(at, keys[i]->data() + shared, keys[i]->size() - shared);
+        at += keys[i]->size() - shared;
+    }
+    return static_cast<uint32_t>(offset);
+}
+
+inline size_t prefix_btree::size() const {
+    return size_;
+}
+
+inline bool prefix_btree::empty() const {
+    return size_ == 0;
+}
+
+inline size_t prefix_btree::height() const {
+    return height_;
+}
+
+inline size_t prefix_btree::bytes() const {
+    return bytes_.size();
+}
+
+inline prefix_btree::const_iterator prefix_btree::begin() const {
+    Path path;
+    if (size_ > 0) {
+        descendLeft(path, root_);
+    }
+    return const_iterator(this, std::move(path));
+}
+
+inline prefix_btree::const_iterator prefix_btree::end() const {
+    return const_iterator(this, Path());
+}
+
+/**
+ * Stops at the first node holding elem; otherwise the leaf slot it would
+ * go in, which if past the leaf's last key is moved up to the separator
+ * after it.
+ */
+inline prefix_btree::const_iterator
+prefix_btree::lower_bound(std::string_view elem) const {
+    Path path;
+    if (size_ == 0) {
+        return end();
+    }
+    for (uint32_t node = root_; ; ) {
+        bool found = false;
+        size_t i = search(node, elem, found);
+        path.emplace_back(node, i);
+        if (found) {
+            break;
+        }
+        if (isLeaf(node)) {
+            climb(path);
+            break;
+        }
+        node = child(node, i);
+    }
+    return const_iterator(this, std::move(path));
+}
+
+inline prefix_btree::const_iterator
+prefix_btree::find(std::string_view elem) const {
+    Path path;
+    if (size_ == 0) {
+        return end();
+    }
+    for (uint32_t node = root_; ; ) {
+        bool found = false;
+        size_t i = search(node, elem, found);
+        path.emplace_back(node, i);
+        if (found) {
+            return const_iterator(this, std::move(path));
+        }
+        if (isLeaf(node)) {
+            return end();
+        }
+        node = child(node, i);
+    }
+}
+
+inline bool prefix_btree::contains(std::string_view elem) const {
+    if (size_ == 0) {
+        return false;
+    }
+    for (uint32_t node = root_; ; ) {
+        bool found = false;
+        size_t i = search(node, elem, found);
+        if (found) {
+            return true;
+        }
+        if (isLeaf(node)) {
+            return false;
+        }
+        node = child(node, i);
+    }
+}
+
+inline uint32_t prefix_btree::word(uint32_t node, size_t i) const {
+    uint32_t value;
+    std::memcpy(&value, bytes_.data() + node + i * sizeof(uint32_t)
+              , sizeof(value));
+    return value;
+}
+
+inline size_t prefix_btree::sizeOf(uint32_t node) const {
+    return word(node, kSize);
+}
+
+inline bool prefix_btree::isLeaf(uint32_t node) const {
+    return word(node, kLeaf) != 0;
+}
+
+inline uint32_t prefix_btree::child(uint32_t node, size_t i) const {
+    return word(node, kHeaderWords + sizeOf(node) + i);
+}
+
+inline std::string_view prefix_btree::prefix(uint32_t node) const {
+    size_t size = sizeOf(node);
+    size_t words = kHeaderWords + size + (isLeaf(node) ? 0 : size + 1);
+    return std::string_view(bytes_.data() + node + words * sizeof(uint32_t)
+                          , word(node, kPrefix));
+}
+
+inline std::string_view prefix_btree::suffix(uint32_t node, size_t i) const {
+    std::string_view shared = prefix(node);
+    const char *suffixes = shared.data() + shared.size();
+    uint32_t from = i == 0 ? 0 : word(node, kHeaderWords + i - 1);
+    uint32_t to = word(node, kHeaderWords + i);
+    return std::string_view(suffixes + from, to - from);
+}
+
+inline std::string prefix_btree::key(uint32_t node, size_t i) const {
+    std::string_view shared = prefix(node);
+    std::string_view rest = suffix(node, i);
+    std::string elem;
+    elem.reserve(shared.size() + rest.size());
+    elem.append(shared).append(rest);
+    return elem;
+}
+
+/**
+ * The slot of elem in node, or of the first key greater. elem is checked
+ * against the shared prefix once: if it doesn't start with it, it sorts
+ * before or after every key in the node; if it does, the rest of it is
+ * searched for among the suffixes, one three-way compare a probe.
+ */
+inline size_t prefix_btree::search(uint32_t node, std::string_view elem
+                                 , bool& found) const {
+    found = false;
+    size_t size = sizeOf(node);
+    std::string_view shared = prefix(node);
+    size_t common = std::min(shared.size(), elem.size());
+    int order = elem.substr(0, common).compare(shared.substr(0, common));
+    if (order < 0 || (order == 0 && elem.size() < shared.size())) {
+        return 0;
+    }
+    if (order > 0) {
+        return size;
+    }
+
+    std::string_view rest = elem.substr(shared.size());
+    const char *suffixes = shared.data() + shared.size();
+    size_t lo = 0;
+    size_t hi = size;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        uint32_t from = mid == 0 ? 0 : word(node, kHeaderWords + mid - 1);
+        uint32_t to = word(node, kHeaderWords + mid);
+        int probe = std::string_view(suffixes + from, to - from).compare(rest);
+        if (probe == 0) {
+            found = true;
+            return mid;
+        }
+        if (probe < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+inline void prefix_btree::descendLeft(Path& path, uint32_t node) const {
+    while (!isLeaf(node)) {
+        path.emplace_back(node, 0);
+        node = child(node, 0);
+    }
+    path.emplace_back(node, 0);
+}
+
+/**
+ * Moves a path left past the end of its node up to the next key: the
+ * separator to the right of the first child on the way back up that
+ * isn't its node's last. An empty path is end().
+ */
+inline void prefix_btree::climb(Path& path) const {
+    while (!path.empty() && path.back().second == sizeOf(path.back().first)) {
+        path.pop_back();
+    }
+}
+
+// prefix_btree::const_iterator
+inline prefix_btree::const_iterator::const_iterator(const prefix_btree *tree
+                                                  , Path path)
+    : tree_{tree}
+    , path_{std::move(path)} {
+}
+
+inline prefix_btree::const_iterator::reference
+prefix_btree::const_iterator::operator*() const {
+    return tree_->key(path_.back().first, path_.back().second);
+}
+
+inline prefix_btree::const_iterator&
+prefix_btree::const_iterator::operator++() {
+    uint32_t node = path_.back().first;
+    size_t slot = ++path_.back().second;
+    if (!tree_->isLeaf(node)) {
+        tree_->descendLeft(path_, tree_->child(node, slot));
+    } else {
+        tree_->climb(path_);
+    }
+    return *this;
+}
+
+inline prefix_btree::const_iterator
+prefix_btree::const_iterator::operator++(int) {
+    const_iterator old = *this;
+    ++*this;
+    return old;
+}
+
+inline bool prefix_btree::const_iterator::operator==(
+        const const_iterator& other) const {
+    if (path_.empty() || other.path_.empty()) {
+        return path_.empty() && other.path_.empty();
+    }
+    return path_.back() == other.path_.back();
+}
+
+inline bool prefix_btree::const_iterator::operator!=(
+        const const_iterator& other) const {
+    return !(*this == other);
+}
+
+#endif
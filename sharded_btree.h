@@ -0,0 +1,534 @@
+#ifndef SHARDED_BTREE_H
+#define SHARDED_BTREE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "btree.h"
+
+const size_t kRouteReaderSlots = 16;
+
+/**
+ * A set split by key range over several btrees, each behind a lock of its
+ * own, so that threads inserting into different parts of the key space
+ * don't queue on the same root. Shard i holds the elements from boundary
+ * i - 1 up to, not including, boundary i; the first and last shards are
+ * open ended.
+ *
+ * Threads find their shard in a routing table of the boundaries, then
+ * lock only that shard. The table is replaced, never changed, when the
+ * boundaries move, and each shard keeps its own copy of its bounds under
+ * its lock: an operation that routed by an outdated table notices once it
+ * holds the lock and routes again. A replaced table is freed as soon as
+ * the threads that were reading it are done, so only one is ever kept.
+ *
+ * A shard holding more than twice the average number of elements is
+ * hot. The insert that makes it so rebalances the whole set: every shard
+ * is locked, the elements are cut into equal slices and each shard is
+ * rebuilt from its slice with btree::bulk_load, in O(n). Inserts only
+ * look at the other shards when their own crosses a limit that moves up
+ * with the average. A shard only turns hot again after taking in about
+ * as many elements as it was left with, so even when every new key lands
+ * in the same shard a rebalance costs O(shards) per insert.
+ */
+template <typename T, typename Compare = std::less<T>
+        , typename Allocator = std::allocator<T>>
+class sharded_btree {
+public:
+    typedef btree<T, Compare, Allocator> shard_type;
+
+    /**
+     * Constructs an empty set with the given shard boundaries, one shard
+     * more than there are boundaries.
+     *
+     * @param boundaries strictly increasing split points
+     * @param maxNodeElems the node size of every shard's btree
+     * @param comp the strict weak ordering of the elements
+     */
+    explicit sharded_btree(std::vector<T> boundaries
+                         , size_t maxNodeElems = 40
+                         , const Compare& comp = Compare());
+
+    /**
+     * Constructs an empty set of shards whose boundaries cut the sample
+     * [first, last) into equal parts, so keys distributed like the sample
+     * spread evenly across the shards.
+     *
+     * @param first, last a sample of the keys to come, in any order
+     * @param shards the number of shards wanted; fewer are made if the
+     *        sample has too few distinct keys
+     */
+    template <typename InputIt>
+    sharded_btree(InputIt first, InputIt last, size_t shards
+                , size_t maxNodeElems = 40, const Compare& comp = Compare());
+
+    sharded_btree(const sharded_btree&) = delete;
+    sharded_btree& operator=(const sharded_btree&) = delete;
+
+    /**
+     * Adds elem unless a matching element is already there, locking only
+     * the shard it belongs to.
+     *
+     * @return true if elem was added
+     */
+    bool insert(const T& elem);
+
+    /**
+     * Inserts every element of [first, last): the batch is routed first
+     * and then each shard takes its share with btree's batched insert
+     * under a single lock.
+     *
+     * @return the number of elements that were not in the set before
+     */
+    template <typename InputIt>
+    size_t insert(InputIt first, InputIt last);
+
+    /**
+     * Removes the matching element, if there is one.
+     *
+     * @return the number of elements removed, 0 or 1
+     */
+    size_t erase(const T& elem);
+
+    /**
+     * Looks elem up in its shard.
+     *
+     * @return a copy of the matching element, or nothing
+     */
+    std::optional<T> find(const T& elem) const;
+    bool contains(const T& elem) const;
+
+    /**
+     * Calls visit on every element in order, going through the shards
+     * one after the other and holding each one's lock while it is read.
+     * Each shard is seen as it was at one moment, though not necessarily
+     * the same moment for all of them; visit must not call back into the
+     * set.
+     */
+    template <typename Visit>
+    void for_each(Visit visit) const;
+
+    /**
+     * The number of elements, summed up shard by shard.
+     */
+    size_t size() const;
+    size_t shards() const;
+
+    /**
+     * The current split points between the shards.
+     */
+    std::vector<T> boundaries() const;
+
+    /**
+     * Moves the boundaries so that every shard holds the same number of
+     * elements, give or take one. Called on its own when a shard turns
+     * hot; a set loaded with a skewed sample can also be evened out by
+     * hand.
+     */
+    void rebalance();
+
+private:
+    struct Shard {
+        Shard(size_t maxNodeElems, const Compare& comp);
+
+        std::mutex mutex;
+        shard_type tree;
+        std::optional<T> lo;
+        std::optional<T> hi;
+
+        // tree.size() for threads that don't hold the lock
+        std::atomic<size_t> elems;
+    };
+
+    // a snapshot of the boundaries, replaced whole when they move
+    struct Routes {
+        std::vector<T> boundaries;
+    };
+
+    // the threads reading a routing table, spread over slots with a cache
+    // line each so that routing threads don't contend on one counter
+    struct alignas(64) ReaderCount {
+        std::atomic<size_t> count{0};
+    };
+
+    void makeShards(std::vector<T> boundaries, size_t maxNodeElems);
+    void publish(std::vector<T> boundaries);
+    ReaderCount& enterRoutes() const;
+    size_t route(const T& elem) const;
+    bool holds(const Shard& shard, const T& elem) const;
+    std::unique_lock<std::mutex> lockShardOf(const T& elem
+                                           , Shard *&shard) const;
+    void setLimit(size_t elems);
+    void coolDown();
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::unique_ptr<Routes> routeTable_;
+    std::atomic<const Routes*> routes_;
+    std::atomic<size_t> routeEpoch_;
+    mutable ReaderCount routeReaders_[2][kRouteReaderSlots];
+    std::atomic<size_t> hotLimit_;
+    std::mutex rebalancing_;
+    Compare comp_;
+};
+
+// sharded_btree
+template <typename T, typename Compare, typename Allocator>
+sharded_btree<T, Compare, Allocator>::Shard::Shard(size_t maxNodeElems
+                                                 , const Compare& comp)
+    : mutex{}
+    , tree{maxNodeElems, comp}
+    , lo{}
+    , hi{}
+    , elems{0} {
+}
+
+template <typename T, typename Compare, typename Allocator>
+sharded_btree<T, Compare, Allocator>::sharded_btree(std::vector<T> boundaries
+                                                  , size_t maxNodeElems
+                                                  , const Compare& comp)
+    : shards_{}
+    , routeTable_{}
+    , routes_{nullptr}
+    , routeEpoch_{0}
+    , routeReaders_{}
+    , hotLimit_{0}
+    , rebalancing_{}
+    , comp_{comp} {
+    makeShards(std::move(boundaries), maxNodeElems);
+}
+
+template <typename T, typename Compare, typename Allocator>
+template <typename InputIt>
+sharded_btree<T, Compare, Allocator>::sharded_btree(InputIt first
+                                                  , InputIt last
+                                                  , size_t shards
+                                                  , size_t maxNodeElems
+                                                  , const Compare& comp)
+    : shards_{}
+    , routeTable_{}
+    , routes_{nullptr}
+    , routeEpoch_{0}
+    , routeReaders_{}
+    , hotLimit_{0}
+    , rebalancing_{}
+    , comp_{comp} {
+    std::vector<T> sample(first, last);
+    std::sort(sample.begin(), sample.end(), comp_);
+    sample.erase(std::unique(sample.begin(), sample.end()
+                           , [this](const T& lhs, const T& rhs) {
+                                 return !comp_(lhs, rhs);
+                             })
+               , sample.end());
+    shards = std::max<size_t>(1, std::min(shards, sample.size()));
+    std::vector<T> boundaries;
+    for (size_t i = 1; i < shards; ++i) {
+        boundaries.push_back(sample[i * sample.size() / shards]);
+    }
+    makeShards(std::move(boundaries), maxNodeElems);
+}
+
+template <typename T, typename Compare, typename Allocator>
+void sharded_btree<T, Compare, Allocator>::makeShards(std::vector<T> boundaries
+                                                    , size_t maxNodeElems) {
+    for (size_t i = 0; i <= boundaries.size(); ++i) {
+        shards_.emplace_back(new Shard(maxNodeElems, comp_));
+        if (i > 0) {
+            shards_[i]->lo = boundaries[i - 1];
+        }
+        if (i < boundaries.size()) {
+            shards_[i]->hi = boundaries[i];
+        }
+    }
+    publish(std::move(boundaries));
+    setLimit(0);
+}
+
+/**
+ * Puts up a new routing table and frees the one it replaces once no
+ * thread can still be reading it. Readers count themselves in under the
+ * epoch they saw, so after flipping the epoch only the readers counted
+ * under the old one need waiting for: any that come later see the epoch
+ * flipped, and so the new table, which went up first. They only hold a
+ * table long enough to route one element. Tables are only replaced with
+ * every shard locked, or before there are any readers, so one thread at
+ * a time does this.
+ */
+template <typename T, typename Compare, typename Allocator>
+void sharded_btree<T, Compare, Allocator>::publish(std::vector<T> boundaries) {
+    std::unique_ptr<Routes> table(new Routes{std::move(boundaries)});
+    routes_.store(table.get());
+    size_t retired = routeEpoch_.load();
+    routeEpoch_.store(1 - retired);
+    for (ReaderCount& readers : routeReaders_[retired]) {
+        while (readers.count.load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+    routeTable_ = std::move(table);
+}
+
+/**
+ * Counts the calling thread in as reading the current routing table,
+ * under the epoch it is still in once counted, and returns the count to
+ * take it out of again when it is done.
+ */
+template <typename T, typename Compare, typename Allocator>
+typename sharded_btree<T, Compare, Allocator>::ReaderCount&
+sharded_btree<T, Compare, Allocator>::enterRoutes() const {
+    static thread_local size_t slot = std::hash<std::thread::id>()(
+            std::this_thread::get_id()) % kRouteReaderSlots;
+    while (true) {
+        size_t epoch = routeEpoch_.load();
+        ReaderCount& readers = routeReaders_[epoch][slot];
+        readers.count.fetch_add(1);
+        if (routeEpoch_.load() == epoch) {
+            return readers;
+        }
+        readers.count.fetch_sub(1);
+    }
+}
+
+/**
+ * The shard elem belonged to as of the latest routing table, which may
+ * have been replaced by the time the caller gets to the shard.
+ */
+template <typename T, typename Compare, typename Allocator>
+size_t sharded_btree<T, Compare, Allocator>::route(const T& elem) const {
+    ReaderCount& readers = enterRoutes();
+    const std::vector<T>& boundaries = routes_.load()->boundaries;
+    size_t shard = std::upper_bound(boundaries.begin(), boundaries.end()
+                                  , elem, comp_)
+                 - boundaries.begin();
+    readers.count.fetch_sub(1, std::memory_order_release);
+    return shard;
+}
+
+template <typename T, typename Compare, typename Allocator>
+bool sharded_btree<T, Compare, Allocator>::holds(const Shard& shard
+                                               , const T& elem) const {
+    return (!shard.lo || !comp_(elem, *shard.lo))
+            && (!shard.hi || comp_(elem, *shard.hi));
+}
+
+/**
+ * Locks the shard elem belongs to, routing again for as long as the
+ * shard reached turns out not to hold elem's range any more.
+ */
+template <typename T, typename Compare, typename Allocator>
+std::unique_lock<std::mutex>
+sharded_btree<T, Compare, Allocator>::lockShardOf(const T& elem
+                                                , Shard *&shard) const {
+    while (true) {
+        shard = shards_[route(elem)].get();
+        std::unique_lock<std::mutex> lock(shard->mutex);
+        if (holds(*shard, elem)) {
+            return lock;
+        }
+    }
+}
+
+/**
+ * Sets the shard size past which an insert checks for a hot shard: twice
+ * the average shard for a set of elems elements. Small sets aren't worth
+ * rebalancing.
+ */
+template <typename T, typename Compare, typename Allocator>
+void sharded_btree<T, Compare, Allocator>::setLimit(size_t elems) {
+    const size_t kMinHotShard = 1024;
+    hotLimit_.store(std::max(kMinHotShard, 2 * elems / shards_.size())
+                  , std::memory_order_relaxed);
+}
+
+/**
+ * Called when an insert took its shard past the limit: rebalances if the
+ * shard is hot against the current average, otherwise moves the limit up
+ * to match the set as it is now. Nothing happens if another thread is at
+ * it already. Must be called without holding any shard's lock.
+ */
+template <typename T, typename Compare, typename Allocator>
+void sharded_btree<T, Compare, Allocator>::coolDown() {
+    std::unique_lock<std::mutex> rebalancing(rebalancing_, std::try_to_lock);
+    if (!rebalancing) {
+        return;
+    }
+    size_t total = 0;
+    size_t largest = 0;
+    for (const auto& shard : shards_) {
+        size_t elems = shard->elems.load(std::memory_order_relaxed);
+        total += elems;
+        largest = std::max(largest, elems);
+    }
+    setLimit(total);
+    if (largest > hotLimit_.load(std::memory_order_relaxed)) {
+        rebalance();
+    }
+}
+
+template <typename T, typename Compare, typename Allocator>
+bool sharded_btree<T, Compare, Allocator>::insert(const T& elem) {
+    Shard *shard = nullptr;
+    bool added = false;
+    bool hot = false;
+    {
+        std::unique_lock<std::mutex> lock = lockShardOf(elem, shard);
+        added = shard->tree.insert(elem).second;
+        shard->elems.store(shard->tree.size(), std::memory_order_relaxed);
+        hot = shard->tree.size() > hotLimit_.load(std::memory_order_relaxed);
+    }
+    if (hot) {
+        coolDown();
+    }
+    return added;
+}
+
+template <typename T, typename Compare, typename Allocator>
+template <typename InputIt>
+size_t sharded_btree<T, Compare, Allocator>::insert(InputIt first
+                                                  , InputIt last) {
+    std::vector<T> batch(first, last);
+    std::sort(batch.begin(), batch.end(), comp_);
+
+    // the batch is sorted, so each shard's share is a run of it; a share
+    // whose shard moved under us goes round again
+    size_t added = 0;
+    bool hot = false;
+    auto next = batch.begin();
+    while (next != batch.end()) {
+        Shard *shard = nullptr;
+        std::unique_lock<std::mutex> lock = lockShardOf(*next, shard);
+        auto end = shard->hi
+                ? std::lower_bound(next, batch.end(), *shard->hi, comp_)
+                : batch.end();
+        added += shard->tree.insert(next, end);
+        shard->elems.store(shard->tree.size(), std::memory_order_relaxed);
+        hot = hot || shard->tree.size()
+                        > hotLimit_.load(std::memory_order_relaxed);
+        next = end;
+    }
+    if (hot) {
+        coolDown();
+    }
+    return added;
+}
+
+template <typename T, typename Compare, typename Allocator>
+size_t sharded_btree<T, Compare, Allocator>::erase(const T& elem) {
+    Shard *shard = nullptr;
+    std::unique_lock<std::mutex> lock = lockShardOf(elem, shard);
+    size_t erased = shard->tree.erase(elem);
+    shard->elems.store(shard->tree.size(), std::memory_order_relaxed);
+    return erased;
+}
+
+template <typename T, typename Compare, typename Allocator>
+std::optional<T> sharded_btree<T, Compare, Allocator>::find(
+        const T& elem) const {
+    Shard *shard = nullptr;
+    std::unique_lock<std::mutex> lock = lockShardOf(elem, shard);
+    const shard_type& tree = shard->tree;
+    auto iter = tree.find(elem);
+    if (iter == tree.cend()) {
+        return std::nullopt;
+    }
+    return *iter;
+}
+
+template <typename T, typename Compare, typename Allocator>
+bool sharded_btree<T, Compare, Allocator>::contains(const T& elem) const {
+    Shard *shard = nullptr;
+    std::unique_lock<std::mutex> lock = lockShardOf(elem, shard);
+    const shard_type& tree = shard->tree;
+    return tree.find(elem) != tree.cend();
+}
+
+template <typename T, typename Compare, typename Allocator>
+template <typename Visit>
+void sharded_btree<T, Compare, Allocator>::for_each(Visit visit) const {
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const T& elem : shard->tree) {
+            visit(elem);
+        }
+    }
+}
+
+template <typename T, typename Compare, typename Allocator>
+size_t sharded_btree<T, Compare, Allocator>::size() const {
+    size_t elems = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        elems += shard->tree.size();
+    }
+    return elems;
+}
+
+template <typename T, typename Compare, typename Allocator>
+size_t sharded_btree<T, Compare, Allocator>::shards() const {
+    return shards_.size();
+}
+
+template <typename T, typename Compare, typename Allocator>
+std::vector<T> sharded_btree<T, Compare, Allocator>::boundaries() const {
+    ReaderCount& readers = enterRoutes();
+    std::vector<T> boundaries = routes_.load()->boundaries;
+    readers.count.fetch_sub(1, std::memory_order_release);
+    return boundaries;
+}
+
+/**
+ * Locks every shard, in order, and deals the elements out again in equal
+ * slices. The new routing table goes up before any shard is unlocked.
+ * Shards are only ever locked in order here and one at a time elsewhere,
+ * so there is no lock order to get wrong.
+ */
+template <typename T, typename Compare, typename Allocator>
+void sharded_btree<T, Compare, Allocator>::rebalance() {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (auto& shard : shards_) {
+        locks.emplace_back(shard->mutex);
+    }
+
+    size_t count = shards_.size();
+    size_t total = 0;
+    for (auto& shard : shards_) {
+        total += shard->tree.size();
+    }
+    if (total < count) {
+        // too few to give every shard one, leave things as they are
+        setLimit(total);
+        return;
+    }
+
+    // the elements are copied out, as a shard's nodes may be shared
+    std::vector<T> elems;
+    elems.reserve(total);
+    for (auto& shard : shards_) {
+        elems.insert(elems.end(), shard->tree.cbegin(), shard->tree.cend());
+    }
+
+    std::vector<T> boundaries;
+    for (size_t i = 0; i < count; ++i) {
+        auto from = elems.begin() + i * elems.size() / count;
+        auto to = elems.begin() + (i + 1) * elems.size() / count;
+        Shard& shard = *shards_[i];
+        shard.tree.bulk_load(from, to);
+        shard.elems.store(shard.tree.size(), std::memory_order_relaxed);
+        shard.lo = (i > 0) ? std::optional<T>(*from) : std::nullopt;
+        if (i > 0) {
+            boundaries.push_back(*from);
+            shards_[i - 1]->hi = *from;
+        }
+    }
+    publish(std::move(boundaries));
+    setLimit(elems.size());
+}
+
+#endif
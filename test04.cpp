@@ -0,0 +1,49 @@
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+
+#include "btree.h"
+
+/**
+ * Inserts a million sequential longs, the worst case for a tree that
+ * never splits, and checks the tree stays as shallow as a B-Tree must:
+ * every node but the root holds at least half of maxNodeElems, so the
+ * height can not exceed 1 + log_{t}((n + 1) / 2) with t the minimum
+ * number of children of a non-root node.
+ **/
+int main(void) {
+  const long kNumElems = 1000000;
+  const size_t kMaxNodeElems = 40;
+
+  btree<long> b(kMaxNodeElems);
+  for (long i = 0; i < kNumElems; ++i) {
+    b.insert(i);
+  }
+
+  long expected = 0;
+  for (btree<long>::const_iterator iter = b.cbegin(); iter != b.cend(); ++iter) {
+    if (*iter != expected++) {
+      std::cout << "out of order at " << *iter << std::endl;
+      return 1;
+    }
+  }
+  if (expected != kNumElems) {
+    std::cout << "expected " << kNumElems << " elements, saw " 
+              << expected << std::endl;
+    return 1;
+  }
+
+  const double minChildren = kMaxNodeElems / 2 + 1;
+  const size_t maxHeight = 1 + static_cast<size_t>(
+      std::floor(std::log((kNumElems + 1) / 2.0) / std::log(minChildren)));
+
+  std::cout << "height after " << kNumElems << " sequential inserts: " 
+            << b.height() << std::endl;
+  if (b.height() > maxHeight) {
+    std::cout << "exceeds the B-Tree bound of " << maxHeight << std::endl;
+    return 1;
+  }
+  std::cout << "within the B-Tree bound of " << maxHeight << std::endl;
+
+  return 0;
+}
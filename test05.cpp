@@ -0,0 +1,67 @@
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "btree.h"
+
+/**
+ * Builds trees on top of btree_pool_allocator: a tree with a pool of its
+ * own, a copy (which gets a fresh pool), and two trees one after the other
+ * on a shared pool to check freed nodes are recycled rather than new
+ * slabs being carved out.
+ **/
+
+template <typename T, typename C, typename A>
+bool inOrder(const btree<T, C, A>& b, long expected) {
+  long count = 0;
+  for (auto iter = b.cbegin(); iter != b.cend(); ++iter) {
+    if (*iter != count++) return false;
+  }
+  return count == expected;
+}
+
+int main(void) {
+  const long kNumElems = 100000;
+  typedef btree<long, std::less<long>, btree_pool_allocator<long>> pooled_btree;
+
+  pooled_btree b(40);
+  for (long i = kNumElems - 1; i >= 0; --i) {
+    b.insert(i);
+  }
+  std::cout << "pooled tree in order: " << inOrder(b, kNumElems) << std::endl;
+
+  pooled_btree copy = b;
+  copy.insert(kNumElems);
+  std::cout << "copy in order: " << inOrder(copy, kNumElems + 1) << std::endl;
+  std::cout << "original untouched: " << inOrder(b, kNumElems) << std::endl;
+
+  auto pool = std::make_shared<btree_node_pool>();
+  btree_pool_allocator<long> shared(pool);
+  size_t slabs = 0;
+  {
+    pooled_btree first(40, shared);
+    for (long i = 0; i < kNumElems; ++i) {
+      first.insert(i);
+    }
+    slabs = pool->slabCount();
+  }
+  std::cout << "shared pool empty after first tree: " 
+            << (pool->bytesInUse() == 0) << std::endl;
+  {
+    pooled_btree second(40, shared);
+    for (long i = 0; i < kNumElems; ++i) {
+      second.insert(i);
+    }
+    std::cout << "second tree reused the slabs: " 
+              << (pool->slabCount() == slabs) << std::endl;
+  }
+
+  btree<std::string, std::less<std::string>
+      , btree_pool_allocator<std::string>> words;
+  words.insert("comp6771");
+  words.insert("comp3000");
+  words.insert("comp1000");
+  std::cout << words;
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+
+/**
+ * Builds trees with the bulk loading constructor and bulk_load(): the
+ * word list, the same words once sorted and once reversed and
+ * duplicated, and a tree loaded half full that then takes more inserts.
+ * Then grows a tree from unsorted batches with the batched insert.
+ **/
+
+template <typename T>
+bool sameAs(const btree<T>& b, const std::vector<T>& expected) {
+  if (!std::equal(expected.begin(), expected.end(), b.begin())) return false;
+  for (const T& elem : expected) {
+    if (b.find(elem) == b.end()) return false;
+  }
+  return std::distance(b.begin(), b.end()) 
+          == static_cast<std::ptrdiff_t>(expected.size());
+}
+
+int main(void) {
+  std::ifstream wordFile("twl.txt");
+  if (!wordFile) return 1;
+
+  std::vector<std::string> words;
+  std::string word;
+  while (std::getline(wordFile, word)) words.push_back(word);
+
+  std::vector<std::string> sortedWords(words);
+  std::sort(sortedWords.begin(), sortedWords.end());
+
+  btree<std::string> fromFile(words.begin(), words.end(), 8);
+  std::cout << "word list: " << sameAs(fromFile, sortedWords) 
+            << ", height " << fromFile.height() << std::endl;
+
+  btree<std::string> sorted(sortedWords.begin(), sortedWords.end(), 8);
+  std::cout << "sorted words: " << sameAs(sorted, sortedWords) 
+            << ", height " << sorted.height() << std::endl;
+
+  std::vector<std::string> doubled(sortedWords.rbegin(), sortedWords.rend());
+  doubled.insert(doubled.end(), words.begin(), words.end());
+  btree<std::string> unsorted(8);
+  unsorted.bulk_load(doubled.begin(), doubled.end());
+  std::cout << "reversed and doubled words: " << sameAs(unsorted, sortedWords) 
+            << std::endl;
+
+  std::vector<long> evens;
+  for (long i = 0; i < 100000; i += 2) evens.push_back(i);
+  btree<long> halfFull(40);
+  halfFull.bulk_load(evens.begin(), evens.end(), 0.5);
+  std::cout << "half full height " << halfFull.height() << std::endl;
+  std::vector<long> all;
+  for (long i = 0; i < 100000; ++i) {
+    halfFull.insert(i);
+    all.push_back(i);
+  }
+  std::cout << "after filling in the odds: " << sameAs(halfFull, all) 
+            << ", height " << halfFull.height() << std::endl;
+
+  btree<long> batched(16);
+  std::vector<long> batch;
+  size_t added = 0;
+  for (long round = 0; round < 10; ++round) {
+    batch.clear();
+    for (long i = 0; i < 10000; ++i) batch.push_back((i * 7919 + round * 31) % 50000);
+    added += batched.insert(batch.begin(), batch.end());
+  }
+  std::set<long> unique;
+  for (long round = 0; round < 10; ++round) {
+    for (long i = 0; i < 10000; ++i) unique.insert((i * 7919 + round * 31) % 50000);
+  }
+  std::vector<long> expected(unique.begin(), unique.end());
+  std::cout << "batches added " << added << ": " << sameAs(batched, expected) 
+            << std::endl;
+
+  return 0;
+}
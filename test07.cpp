@@ -0,0 +1,101 @@
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "btree.h"
+
+/**
+ * Erases from trees built by insertion: every other element one at a
+ * time, elements found through iterators, and whole ranges, checking the
+ * contents against a std::set after each step. A tree on its own pool
+ * shows the nodes being handed back as it shrinks.
+ **/
+
+template <typename T, typename C, typename A>
+bool sameAs(const btree<T, C, A>& b, const std::set<T>& expected) {
+  auto iter = b.begin();
+  for (const T& elem : expected) {
+    if (iter == b.end() || *iter != elem) return false;
+    ++iter;
+  }
+  return iter == b.end();
+}
+
+int main(void) {
+  const long kNumElems = 100000;
+  typedef btree<long, std::less<long>, btree_pool_allocator<long>> pooled_btree;
+
+  auto pool = std::make_shared<btree_node_pool>();
+  pooled_btree b(40, btree_pool_allocator<long>(pool));
+  std::set<long> expected;
+  for (long i = 0; i < kNumElems; ++i) {
+    b.insert((i * 7919) % kNumElems);
+    expected.insert(i);
+  }
+  size_t fullBytes = pool->bytesInUse();
+
+  size_t erased = 0;
+  for (long i = 1; i < kNumElems; i += 2) {
+    erased += b.erase(i);
+    expected.erase(i);
+  }
+  erased += b.erase(kNumElems);
+  std::cout << "erased the odds: " << erased << ", " << sameAs(b, expected)
+            << ", height " << b.height() << std::endl;
+
+  long removed = 0;
+  for (auto iter = b.begin(); iter != b.end(); ) {
+    if (*iter % 3 == 0) {
+      expected.erase(*iter);
+      iter = b.erase(iter);
+      ++removed;
+    } else {
+      ++iter;
+    }
+  }
+  std::cout << "erased multiples of 3 through iterators: " << removed
+            << ", " << sameAs(b, expected) << std::endl;
+
+  auto first = b.find(20000);
+  auto last = b.find(80000);
+  auto after = b.erase(first, last);
+  expected.erase(expected.find(20000), expected.find(80000));
+  std::cout << "erased [20000, 80000): " << sameAs(b, expected)
+            << ", next " << *after << ", height " << b.height() << std::endl;
+
+  b.erase(b.find(90002), b.end());
+  expected.erase(expected.find(90002), expected.end());
+  std::cout << "erased the tail: " << sameAs(b, expected) << std::endl;
+
+  size_t bytes = pool->bytesInUse();
+  std::cout << "nodes returned: " << (bytes * 10 < fullBytes) << std::endl;
+
+  b.erase(b.begin(), b.end());
+  std::cout << "erased everything: " << (b.begin() == b.end()) 
+            << ", height " << b.height() << ", bytes in use "
+            << pool->bytesInUse() << std::endl;
+
+  btree<std::string> words(4);
+  std::set<std::string> wordSet;
+  for (long i = 0; i < 1000; ++i) {
+    std::string word = std::to_string(i * 37 % 1000);
+    words.insert(word);
+    wordSet.insert(word);
+  }
+  for (long i = 0; i < 1000; i += 7) {
+    std::string lo = std::to_string(i);
+    std::string hi = std::to_string(i + 3);
+    auto from = wordSet.lower_bound(lo);
+    auto to = wordSet.lower_bound(hi);
+    if (from == wordSet.end() || !(*from < hi)) continue;
+    words.erase(words.find(*from)
+              , to == wordSet.end() ? words.end() : words.find(*to));
+    wordSet.erase(from, to);
+  }
+  std::cout << "string ranges: " << sameAs(words, wordSet) << ", "
+            << wordSet.size() << " left" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "btree.h"
+
+/**
+ * Orders trees with comparators other than operator<: std::greater,
+ * std::less<> looked up by const char* and std::string_view, and a
+ * case-insensitive comparator with a three-way compare member, counting
+ * its calls to check lookups take one comparison per probe. A key with
+ * a compare member of its own that isn't a three-way comparison must be
+ * ordered by its operator< all the same. Trees move assign with a
+ * comparator that can't be copy assigned.
+ **/
+
+struct caseless {
+  mutable long calls = 0;
+  mutable long compares = 0;
+
+  static int fold(const std::string& lhs, const std::string& rhs) {
+    size_t n = std::min(lhs.size(), rhs.size());
+    for (size_t i = 0; i < n; ++i) {
+      int l = std::tolower(static_cast<unsigned char>(lhs[i]));
+      int r = std::tolower(static_cast<unsigned char>(rhs[i]));
+      if (l != r) return l < r ? -1 : 1;
+    }
+    return (lhs.size() > n) - (rhs.size() > n);
+  }
+
+  bool operator()(const std::string& lhs, const std::string& rhs) const {
+    ++calls;
+    return fold(lhs, rhs) < 0;
+  }
+
+  int compare(const std::string& lhs, const std::string& rhs) const {
+    ++compares;
+    return fold(lhs, rhs);
+  }
+};
+
+// can be swapped and copied, but not copy assigned
+struct byLength {
+  byLength() = default;
+  byLength(const byLength&) = default;
+  byLength(byLength&&) = default;
+  byLength& operator=(const byLength&) = delete;
+  byLength& operator=(byLength&&) = default;
+
+  bool operator()(const std::string& lhs, const std::string& rhs) const {
+    return lhs.size() != rhs.size() ? lhs.size() < rhs.size() : lhs < rhs;
+  }
+};
+
+struct ranked {
+  int rank;
+
+  bool operator<(const ranked& other) const { return rank < other.rank; }
+
+  // not a three-way comparison, and the other way round to operator<
+  bool compare(const ranked& other) const { return rank > other.rank; }
+};
+
+int main(void) {
+  std::ifstream wordFile("twl.txt");
+  if (!wordFile) return 1;
+  std::vector<std::string> words;
+  std::string word;
+  while (std::getline(wordFile, word)) words.push_back(word);
+
+  btree<int, std::greater<int>> descending(8);
+  for (int i = 0; i < 1000; ++i) descending.insert((i * 37) % 1000);
+  std::vector<int> batch;
+  for (int i = 1000; i < 2000; ++i) batch.push_back(i);
+  descending.insert(batch.begin(), batch.end());
+  for (int i = 0; i < 2000; i += 2) descending.erase(i);
+  bool ordered = std::is_sorted(descending.begin(), descending.end()
+                              , std::greater<int>());
+  std::cout << "descending: " << ordered << ", first " << *descending.begin()
+            << ", found 1001 " << (descending.find(1001) != descending.end())
+            << ", found 1000 " << (descending.find(1000) != descending.end())
+            << std::endl;
+
+  btree<std::string, std::less<>> transparent(words.begin(), words.end(), 16);
+  const char *probe = words[500].c_str();
+  std::string_view view(words[123]);
+  std::cout << "const char* lookup: " << (*transparent.find(probe) == probe)
+            << ", string_view lookup: " << (*transparent.find(view) == view)
+            << ", missing: " << (transparent.find("zzzzz") == transparent.end())
+            << std::endl;
+
+  btree<std::string, caseless> folded(16);
+  for (const std::string& w : words) {
+    std::string upper(w);
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    folded.insert(upper);
+  }
+  long callsBefore = folded.key_comp().calls;
+  long comparesBefore = folded.key_comp().compares;
+  long found = 0;
+  for (const std::string& w : words) {
+    found += (folded.find(w) != folded.end());
+  }
+  std::cout << "case-insensitive finds: " << found << " of " << words.size()
+            << ", ordering calls " << folded.key_comp().calls - callsBefore
+            << ", three-way calls "
+            << folded.key_comp().compares - comparesBefore << std::endl;
+
+  btree<ranked> byRank(8);
+  for (int i = 0; i < 500; ++i) byRank.insert(ranked{(i * 37) % 500});
+  long rankedFound = 0;
+  for (int i = 0; i < 500; ++i) {
+    rankedFound += byRank.find(ranked{i}) != byRank.end();
+  }
+  std::cout << "key with a compare member: ordered "
+            << std::is_sorted(byRank.begin(), byRank.end()) << ", size "
+            << byRank.size() << ", finds " << rankedFound << std::endl;
+
+  btree<std::string, byLength> shortest(8);
+  btree<std::string, byLength> longest(8);
+  for (const std::string& w : words) longest.insert(w);
+  shortest = std::move(longest);
+  shortest = btree<std::string, byLength>(shortest);
+  std::cout << "move assigned, comparator not copy assignable: "
+            << shortest.size() << " words, shortest " << *shortest.begin()
+            << ", moved from " << longest.size() << std::endl;
+
+  return 0;
+}
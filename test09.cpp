@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+
+/**
+ * Queries a tree by bounds rather than exact matches: lower_bound,
+ * upper_bound and equal_range around present and absent elements,
+ * range() views over words sharing a prefix, and every window of a
+ * tree of evens checked against std::set.
+ **/
+
+int main(void) {
+  std::ifstream wordFile("twl.txt");
+  if (!wordFile) return 1;
+  std::vector<std::string> words;
+  std::string word;
+  while (std::getline(wordFile, word)) words.push_back(word);
+
+  const btree<std::string, std::less<>> b(words.begin(), words.end(), 12);
+  std::set<std::string> expected(words.begin(), words.end());
+
+  const std::string& present = *std::next(expected.begin(), 400);
+  std::cout << "lower_bound(present) is itself: " 
+            << (*b.lower_bound(present) == present) << std::endl;
+  std::cout << "upper_bound(present) is next: "
+            << (*b.upper_bound(present) == *expected.upper_bound(present)) 
+            << std::endl;
+  auto matches = b.equal_range(present);
+  std::cout << "equal_range(present) holds " 
+            << std::distance(matches.first, matches.second) << std::endl;
+
+  std::string absent = present + "zzz";
+  auto none = b.equal_range(absent);
+  std::cout << "equal_range(absent) holds " 
+            << std::distance(none.first, none.second)
+            << ", starts at " << (*none.first == *expected.lower_bound(absent))
+            << std::endl;
+  std::cout << "past the last word: " << (b.lower_bound("ZZZZ") == b.end())
+            << std::endl;
+
+  for (const char *prefix : {"YE", "YT", "ZA", "ZY", "AB"}) {
+    std::string hi(prefix);
+    ++hi.back();
+    std::vector<std::string> got;
+    for (const std::string& w : b.range(prefix, hi.c_str())) got.push_back(w);
+    std::vector<std::string> want(expected.lower_bound(prefix)
+                                , expected.lower_bound(hi));
+    std::cout << "words starting with " << prefix << ": " << got.size() 
+              << ", " << (got == want) << std::endl;
+  }
+  std::cout << "backwards range is empty: " << b.range("ZO", "YE").empty() 
+            << std::endl;
+
+  btree<int> evens(5);
+  std::set<int> evenSet;
+  for (int i = 0; i < 2000; i += 2) {
+    evens.insert(i);
+    evenSet.insert(i);
+  }
+  bool windows = true;
+  for (int lo = -3; lo < 2003 && windows; lo += 7) {
+    for (int hi = lo; hi < lo + 60; hi += 11) {
+      auto view = evens.range(lo, hi);
+      windows = windows && std::equal(view.begin(), view.end()
+                                    , evenSet.lower_bound(lo)
+                                    , evenSet.lower_bound(hi));
+    }
+  }
+  std::cout << "every window matches: " << windows << std::endl;
+
+  return 0;
+}
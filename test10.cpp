@@ -0,0 +1,83 @@
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+
+/**
+ * Keeps track of the size of trees as they grow and shrink, and on a
+ * counted tree (see btree_policy.h) reads percentiles and pages of
+ * results through rank and select instead of walking from begin().
+ **/
+
+typedef btree<long, std::less<long>, std::allocator<long>
+            , btree_counted_policy> counted_btree;
+
+int main(void) {
+  const long kNumElems = 100000;
+
+  btree<long> plain;
+  std::cout << "empty to start: " << plain.empty() << ", size " 
+            << plain.size() << std::endl;
+  for (long i = 0; i < kNumElems; ++i) {
+    plain.insert((i * 7919) % kNumElems);
+  }
+  plain.insert(42);
+  std::cout << "size after inserts: " << plain.size() << std::endl;
+  for (long i = 0; i < kNumElems; i += 2) {
+    plain.erase(i);
+  }
+  plain.erase(plain.find(1001), plain.find(2001));
+  std::cout << "size after erases: " << plain.size() << std::endl;
+
+  counted_btree scores(16);
+  for (long i = 0; i < kNumElems; ++i) {
+    scores.insert((i * 7919) % kNumElems * 3);
+  }
+  for (long i = 0; i < kNumElems; i += 5) {
+    scores.erase(i * 3);
+  }
+  std::cout << "counted size: " << scores.size() << std::endl;
+  for (int percentile : {0, 25, 50, 90, 99}) {
+    size_t k = scores.size() * percentile / 100;
+    std::cout << "p" << percentile << ": " << *scores.select(k) << std::endl;
+  }
+  std::cout << "below 150003: " << scores.rank(150003) 
+            << ", below 150004: " << scores.rank(150004) << std::endl;
+
+  bool consistent = true;
+  size_t position = 0;
+  for (auto iter = scores.begin(); iter != scores.end(); ++iter, ++position) {
+    consistent = consistent && scores.rank(*iter) == position
+                            && scores.select(position) == iter;
+  }
+  std::cout << "rank and select agree with iteration: " << consistent 
+            << std::endl;
+  std::cout << "select past the end: " 
+            << (scores.select(scores.size()) == scores.end()) << std::endl;
+
+  const size_t kPageSize = 5;
+  size_t page = scores.rank(200000) / kPageSize;
+  std::cout << "page " << page << ":";
+  auto iter = scores.select(page * kPageSize);
+  for (size_t i = 0; i < kPageSize && iter != scores.end(); ++i, ++iter) {
+    std::cout << " " << *iter;
+  }
+  std::cout << std::endl;
+
+  std::ifstream wordFile("twl.txt");
+  if (!wordFile) return 1;
+  std::vector<std::string> words;
+  std::string word;
+  while (std::getline(wordFile, word)) words.push_back(word);
+  btree<std::string, std::less<>, std::allocator<std::string>
+      , btree_counted_policy> dictionary(words.begin(), words.end(), 8, {}, {});
+  std::cout << "words: " << dictionary.size() << ", median " 
+            << *dictionary.select(dictionary.size() / 2) 
+            << ", words before ZO: " << dictionary.rank("ZO") << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "concurrent_btree.h"
+
+/**
+ * Searches a concurrent_btree from several threads while two more insert
+ * into it. The readers must find every element that was there before the
+ * writers started and nothing that never goes in; once everyone is done
+ * the tree must hold exactly what was inserted.
+ **/
+
+int main(void) {
+  const long kPreloaded = 20000;
+  const long kInserted = 40000;
+  const int kReaders = 4;
+
+  // small nodes make for plenty of splits under the readers' feet
+  concurrent_btree<long> tree(4);
+  for (long i = 0; i < kPreloaded; ++i) {
+    tree.insert(i * 4);
+  }
+
+  std::atomic<bool> done{false};
+  std::atomic<long> missing{0};
+  std::atomic<long> phantoms{0};
+  std::vector<std::thread> threads;
+  for (int r = 0; r < kReaders; ++r) {
+    threads.emplace_back([&, r]() {
+      for (long round = 0; !done.load() || round < 3; ++round) {
+        for (long i = r; i < kPreloaded; i += kReaders) {
+          if (!tree.contains(i * 4)) ++missing;
+          if (tree.contains(i * 4 + 3)) ++phantoms;
+        }
+      }
+    });
+  }
+  std::vector<std::thread> writers;
+  for (int w = 0; w < 2; ++w) {
+    writers.emplace_back([&, w]() {
+      for (long i = w; i < kInserted; i += 2) {
+        tree.insert((i * 7919) % kInserted * 4 + 1);
+        tree.insert(i * 4);
+      }
+    });
+  }
+  for (auto& writer : writers) writer.join();
+  done = true;
+  for (auto& thread : threads) thread.join();
+
+  std::cout << "preloaded elements missed: " << missing << std::endl;
+  std::cout << "elements never inserted found: " << phantoms << std::endl;
+  std::cout << "size: " << tree.size() << std::endl;
+
+  bool all = true;
+  for (long i = 0; i < kInserted; ++i) {
+    all = all && tree.contains(i * 4 + 1) && tree.contains(i * 4)
+              && !tree.contains(i * 4 + 2);
+  }
+  std::cout << "everything inserted is there: " << all << std::endl;
+  std::cout << "find returns the element: " << *tree.find(404) 
+            << ", absent: " << tree.find(406).has_value() << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,104 @@
+#include <atomic>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "sharded_btree.h"
+
+/**
+ * Fills a sharded_btree from several threads at once, first with keys
+ * spread the way the boundaries expect and then with keys that all land
+ * in the last shard, which has to be rebalanced on the way. The shards
+ * together must still read back in order and hold exactly what went in.
+ * Lookups then run while the set is rebalanced over and over.
+ **/
+
+int main(void) {
+  const long kPerThread = 20000;
+  const int kThreads = 4;
+
+  std::vector<long> sample;
+  for (long i = 0; i < 1000; ++i) {
+    sample.push_back(i * 1000);
+  }
+  sharded_btree<long> set(sample.begin(), sample.end(), 8);
+  std::cout << "shards: " << set.shards() << ", first boundary " 
+            << set.boundaries().front() << std::endl;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (long i = t; i < kPerThread * kThreads; i += kThreads) {
+        set.insert(i * 7919 % (kPerThread * kThreads) * 12);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  std::cout << "spread out: " << set.size() << " elements, boundaries kept: " 
+            << (set.boundaries() == std::vector<long>{
+                    125000, 250000, 375000, 500000, 625000, 750000, 875000}) 
+            << std::endl;
+
+  // everything from here on is above the last boundary
+  threads.clear();
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      std::vector<long> batch;
+      for (long i = t; i < kPerThread * kThreads; i += kThreads) {
+        if (i % 2 == 0) {
+          set.insert(1000000000 + i);
+        } else {
+          batch.push_back(1000000000 + i);
+        }
+        if (batch.size() == 100) {
+          set.insert(batch.begin(), batch.end());
+          batch.clear();
+        }
+      }
+      set.insert(batch.begin(), batch.end());
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  std::vector<long> boundaries = set.boundaries();
+  std::cout << "skewed: " << set.size() << " elements, last boundary moved: " 
+            << (boundaries.back() > 1000000000) << std::endl;
+
+  std::set<long> expected;
+  for (long i = 0; i < kPerThread * kThreads; ++i) {
+    expected.insert(i * 12);
+    expected.insert(1000000000 + i);
+  }
+  std::vector<long> elems;
+  set.for_each([&](long elem) { elems.push_back(elem); });
+  std::cout << "in order and complete: " 
+            << std::equal(elems.begin(), elems.end()
+                        , expected.begin(), expected.end()) << std::endl;
+
+  set.rebalance();
+  std::cout << "after rebalance, found: " << set.contains(1000000000 + 4242)
+            << " " << *set.find(12 * 777) << ", absent: " 
+            << set.contains(5) << std::endl;
+  std::cout << "erased: " << set.erase(12 * 777) << set.erase(12 * 777) 
+            << ", size " << set.size() << std::endl;
+
+  // readers route by tables that rebalances keep replacing and freeing
+  std::atomic<bool> allFound{true};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < kThreads; ++t) {
+    readers.emplace_back([&, t]() {
+      for (long i = t; i < kPerThread; i += kThreads) {
+        if (!set.contains(1000000000 + i) || set.boundaries().empty()) {
+          allFound = false;
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 200; ++i) set.rebalance();
+  for (auto& reader : readers) reader.join();
+  std::cout << "lookups during rebalances all found: " << allFound 
+            << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,65 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+
+/**
+ * Looks up batches of keys with find_many and contains_many, on pools of
+ * several sizes, and checks every result against a plain find. Half of
+ * the probes are in the tree and half are not.
+ **/
+
+int main(void) {
+  const long kNumElems = 200000;
+  btree<long> b;
+  for (long i = 0; i < kNumElems; ++i) {
+    b.insert((i * 7919) % kNumElems * 2);
+  }
+  std::vector<long> probes;
+  for (long i = 0; i < 2 * kNumElems + 10; ++i) {
+    probes.push_back((i * 104729) % (2 * kNumElems + 10));
+  }
+
+  for (size_t threads : {0, 1, 3}) {
+    btree_thread_pool pool(threads);
+    std::vector<const long*> found(probes.size());
+    b.find_many(probes.begin(), probes.end(), found.begin(), pool);
+    std::vector<char> present(probes.size());
+    b.contains_many(probes.data(), probes.data() + probes.size()
+                  , present.data(), pool);
+
+    size_t hits = 0;
+    bool agree = true;
+    for (size_t i = 0; i < probes.size(); ++i) {
+      auto iter = b.find(probes[i]);
+      agree = agree && (iter == b.end() ? found[i] == nullptr 
+                                        : found[i] == &*iter)
+                    && present[i] == (iter != b.end());
+      hits += present[i];
+    }
+    std::cout << "pool of " << pool.concurrency() << ": " << hits << " hits, " 
+              << "agree with find: " << agree << std::endl;
+  }
+
+  std::ifstream wordFile("twl.txt");
+  if (!wordFile) return 1;
+  std::vector<std::string> words;
+  std::string word;
+  while (std::getline(wordFile, word)) words.push_back(word);
+  btree<std::string> dictionary(words.begin(), words.begin() + 500);
+  std::vector<const std::string*> found(words.size());
+  dictionary.find_many(words.begin(), words.end(), found.begin());
+  size_t matched = 0;
+  for (size_t i = 0; i < words.size(); ++i) {
+    matched += (found[i] != nullptr && *found[i] == words[i]);
+  }
+  std::cout << "words found: " << matched << " of " << words.size() 
+            << std::endl;
+  std::vector<const std::string*> none;
+  dictionary.find_many(words.begin(), words.begin(), none.begin());
+  std::cout << "empty batch: ok" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+
+/**
+ * Looks up batches of keys with find_batch, in sizes that fill whole
+ * groups, leave the last one partly full, or are empty, and checks every
+ * result against a plain find.
+ **/
+
+template <typename Tree, typename Key>
+bool agreesWithFind(const Tree& tree, const std::vector<Key>& keys
+                  , const std::vector<const Key*>& found) {
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto iter = tree.find(keys[i]);
+    if (iter == tree.end() ? found[i] != nullptr : found[i] != &*iter) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(void) {
+  const long kNumElems = 100000;
+  btree<long> b(7);
+  for (long i = 0; i < kNumElems; ++i) {
+    b.insert((i * 7919) % kNumElems * 3);
+  }
+
+  for (size_t batch : {0, 1, 15, 16, 17, 1000, 300000}) {
+    std::vector<long> probes;
+    for (size_t i = 0; i < batch; ++i) {
+      probes.push_back(static_cast<long>((i * 104729) % (3 * kNumElems + 5)));
+    }
+    std::vector<const long*> found(batch);
+    b.find_batch(probes.begin(), probes.end(), found.begin());
+    size_t hits = 0;
+    for (const long *match : found) hits += (match != nullptr);
+    std::cout << "batch of " << batch << ": " << hits << " hits, "
+              << "agree with find: " << agreesWithFind(b, probes, found)
+              << std::endl;
+  }
+
+  btree<long> empty;
+  std::vector<long> probes = {1, 2, 3};
+  std::vector<const long*> found(probes.size(), &probes[0]);
+  empty.find_batch(probes.begin(), probes.end(), found.begin());
+  std::cout << "empty tree: " << agreesWithFind(empty, probes, found)
+            << std::endl;
+
+  std::ifstream wordFile("twl.txt");
+  if (!wordFile) return 1;
+  std::vector<std::string> words;
+  std::string word;
+  while (std::getline(wordFile, word)) words.push_back(word);
+  btree<std::string> dictionary(words.begin() + 250, words.end());
+  std::vector<const std::string*> matches(words.size());
+  dictionary.find_batch(words.begin(), words.end(), matches.begin());
+  size_t matched = 0;
+  for (size_t i = 0; i < words.size(); ++i) {
+    matched += (matches[i] != nullptr && *matches[i] == words[i]);
+  }
+  std::cout << "words found: " << matched << " of " << words.size()
+            << ", agree with find: "
+            << agreesWithFind(dictionary, words, matches) << std::endl;
+
+  return 0;
+}
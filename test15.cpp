@@ -0,0 +1,93 @@
+#include <iostream>
+#include <set>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "btree.h"
+
+/**
+ * Copies and snapshots share their nodes until one side changes. Copies
+ * are changed every way the tree can be, inserts, batched inserts,
+ * erases and range erases, and each must still hold exactly its own
+ * elements. A snapshot is then read on another thread while the
+ * original is changed underneath it.
+ **/
+
+template <typename Tree>
+bool holds(const Tree& tree, const std::set<long>& expected) {
+  if (tree.size() != expected.size()) return false;
+  auto next = expected.begin();
+  for (long elem : tree) {
+    if (elem != *next++) return false;
+  }
+  return true;
+}
+
+// shared nodes are only safe if nothing can write through an iterator
+static_assert(std::is_same<btree<long>::iterator::reference
+                         , const long&>::value
+            , "btree iterators must not hand out mutable elements");
+
+int main(void) {
+  const long kNumElems = 20000;
+  btree<long> b(6);
+  std::set<long> expected;
+  for (long i = 0; i < kNumElems; ++i) {
+    b.insert((i * 7919) % kNumElems);
+    expected.insert(i);
+  }
+
+  btree<long> inserted = b;
+  std::set<long> insertedExpected = expected;
+  for (long i = 0; i < 1000; ++i) {
+    inserted.insert(kNumElems + i * 3);
+    insertedExpected.insert(kNumElems + i * 3);
+  }
+  std::vector<long> batch;
+  for (long i = 0; i < 1000; ++i) batch.push_back(kNumElems + i * 7);
+  inserted.insert(batch.begin(), batch.end());
+  insertedExpected.insert(batch.begin(), batch.end());
+
+  btree<long> erased(b);
+  std::set<long> erasedExpected = expected;
+  for (long i = 0; i < kNumElems; i += 3) {
+    erased.erase(i);
+    erasedExpected.erase(i);
+  }
+  erased.erase(erased.lower_bound(5000), erased.lower_bound(9000));
+  erasedExpected.erase(erasedExpected.lower_bound(5000)
+                     , erasedExpected.lower_bound(9000));
+
+  std::cout << "original kept: " << holds(b, expected) << std::endl;
+  std::cout << "copy with inserts: " << holds(inserted, insertedExpected)
+            << std::endl;
+  std::cout << "copy with erases: " << holds(erased, erasedExpected)
+            << std::endl;
+
+  btree<long, std::less<long>, std::allocator<long>, btree_counted_policy> 
+      counted(b.begin(), b.end());
+  auto before = counted.snapshot();
+  counted.erase(counted.begin(), counted.lower_bound(kNumElems / 2));
+  std::cout << "counted snapshot rank: " << before.rank(kNumElems / 2)
+            << ", after erase: " << counted.rank(kNumElems / 2) << std::endl;
+
+  const btree<long> snapshot = b.snapshot();
+  long seen = 0;
+  std::thread reader([&]() {
+    for (int pass = 0; pass < 5; ++pass) {
+      for (long i = 0; i < kNumElems; ++i) {
+        seen += (snapshot.find(i) != snapshot.end());
+      }
+    }
+  });
+  for (long i = 0; i < kNumElems; i += 2) {
+    b.erase(i);
+    b.insert(kNumElems + i);
+  }
+  reader.join();
+  std::cout << "snapshot reads: " << seen << ", snapshot kept: "
+            << holds(snapshot, expected) << std::endl;
+
+  return 0;
+}
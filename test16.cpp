@@ -0,0 +1,97 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "btree.h"
+
+/**
+ * Value semantics without copies: keys that count their copies are
+ * inserted with insert(T&&) and emplace, keys that can only be moved
+ * (a unique_ptr inside) go through insert, find, erase and a move of
+ * the whole tree, and move and copy assignment are checked against the
+ * trees they were made from. Small nodes make every insert likely to
+ * split, so the iterator insert returns is checked to be on the new key.
+ **/
+
+struct Tracked {
+  static long copies;
+  std::string name;
+
+  explicit Tracked(std::string name) : name(std::move(name)) {}
+  Tracked(const Tracked& other) : name(other.name) { ++copies; }
+  Tracked(Tracked&& other) = default;
+  Tracked& operator=(const Tracked& other) {
+    name = other.name;
+    ++copies;
+    return *this;
+  }
+  Tracked& operator=(Tracked&& other) = default;
+  bool operator<(const Tracked& other) const { return name < other.name; }
+};
+
+long Tracked::copies = 0;
+
+struct Unique {
+  std::unique_ptr<long> value;
+
+  explicit Unique(long value) : value(new long(value)) {}
+  bool operator<(const Unique& other) const { return *value < *other.value; }
+};
+
+int main(void) {
+  const long kNumElems = 20000;
+
+  btree<Tracked> names(4);
+  bool landed = true;
+  for (long i = 0; i < kNumElems; ++i) {
+    std::string name = "key" + std::to_string((i * 7919) % kNumElems);
+    auto result = (i % 2 == 0) ? names.insert(Tracked(name)) 
+                               : names.emplace(name);
+    landed = landed && result.second && result.first->name == name;
+  }
+  Tracked again("key17");
+  bool kept = !names.insert(std::move(again)).second && again.name == "key17";
+  std::cout << "inserted " << names.size() << ", iterators on the new key: "
+            << landed << ", copies made: " << Tracked::copies
+            << ", duplicate left alone: " << kept << std::endl;
+
+  btree<Unique> uniques(5);
+  for (long i = 0; i < kNumElems; ++i) {
+    auto result = uniques.insert(Unique((i * 7919) % kNumElems));
+    landed = landed && *result.first->value == (i * 7919) % kNumElems;
+  }
+  for (long i = 0; i < kNumElems; i += 2) {
+    uniques.erase(Unique(i));
+  }
+  uniques.erase(uniques.find(Unique(1)));
+  uniques.emplace(-1);
+  btree<Unique> moved(std::move(uniques));
+  long expected = -1;
+  bool inOrder = true;
+  for (const Unique& key : moved) {
+    inOrder = inOrder && *key.value == expected;
+    expected += (expected == -1) ? 4 : 2;
+  }
+  std::cout << "move-only keys: " << moved.size() << " in order " << inOrder
+            << ", iterators on the new key: " << landed
+            << ", moved-from empty: " << uniques.empty() << std::endl;
+  uniques.insert(Unique(42));
+  std::cout << "moved-from reused: " << uniques.size() << std::endl;
+
+  btree<long> numbers;
+  for (long i = 0; i < 1000; ++i) numbers.insert(i);
+  btree<long> assigned(8);
+  assigned.insert(-5);
+  assigned = numbers;
+  numbers.insert(1000);
+  btree<long> taken;
+  taken = std::move(numbers);
+  btree<long>& alias = taken;
+  taken = alias;
+  std::cout << "copy-assigned: " << assigned.size() << ", move-assigned: "
+            << taken.size() << ", source left with " << numbers.size()
+            << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,215 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "btree.h"
+#include "mapped_btree.h"
+
+/**
+ * Saves a btree<long> big enough for three levels of pages and the word
+ * list as a btree<std::string>, maps both files back and checks find,
+ * lower_bound and a full ordered walk against the trees they came from.
+ * Also opens files that are missing, hold the wrong kind of key, or are
+ * empty trees, and saves keys aligned wider than the node header. Two
+ * threads then save different trees to one path at once, and the file
+ * left must be one of them whole. Last, copies of a saved file damaged
+ * in different ways must fail verify() and still be safe to search and
+ * walk, and one claiming more nodes than it holds must not open at all.
+ **/
+
+struct alignas(16) wide {
+  long value;
+  bool operator<(const wide& other) const { return value < other.value; }
+  bool operator!=(const wide& other) const { return value != other.value; }
+};
+
+template <typename Mapped, typename Tree>
+bool walksLike(const Mapped& mapped, const Tree& tree) {
+  auto next = tree.begin();
+  size_t count = 0;
+  for (auto elem : mapped) {
+    if (next == tree.end() || elem != *next) return false;
+    ++next;
+    ++count;
+  }
+  return next == tree.end() && count == mapped.size();
+}
+
+// writes a copy of the saved file at from with bytes put in at offset
+void damage(const std::string& from, const std::string& to, size_t offset
+          , const void *bytes, size_t count) {
+  std::ifstream in(from, std::ios::binary);
+  std::string file((std::istreambuf_iterator<char>(in))
+                 , std::istreambuf_iterator<char>());
+  std::memcpy(&file[offset], bytes, count);
+  std::ofstream(to, std::ios::binary) << file;
+}
+
+// verify() on the damaged file, then every lookup and a whole walk
+template <typename T, typename Probe>
+bool survives(const std::string& path, const std::vector<Probe>& probes) {
+  mapped_btree<T> mapped(path);
+  bool sound = mapped.verify();
+  size_t steps = 0;
+  for (const Probe& probe : probes) {
+    mapped.find(probe);
+    mapped.lower_bound(probe);
+  }
+  for (auto iter = mapped.begin(); iter != mapped.end(); ++iter) {
+    if (++steps > 10 * mapped.size()) break;
+  }
+  std::remove(path.c_str());
+  return !sound;
+}
+
+int main(void) {
+  const long kNumElems = 300000;
+  btree<long> numbers;
+  for (long i = 0; i < kNumElems; ++i) {
+    numbers.insert((i * 7919) % kNumElems * 2);
+  }
+  std::cout << "saved numbers: " << numbers.save("test17.numbers.map")
+            << std::endl;
+
+  {
+    mapped_btree<long> mapped("test17.numbers.map");
+    bool lookups = true;
+    for (long probe = -1; probe <= 2 * kNumElems; ++probe) {
+      auto found = mapped.find(probe);
+      auto bound = mapped.lower_bound(probe);
+      auto expected = numbers.lower_bound(probe);
+      lookups = lookups
+          && (found != mapped.end()) == (numbers.find(probe) != numbers.end())
+          && (bound == mapped.end() ? expected == numbers.end()
+                                    : *bound == *expected);
+    }
+    std::cout << "open: " << mapped.is_open() << ", size " << mapped.size()
+              << ", height " << mapped.height() << ", lookups agree: "
+              << lookups << ", walk agrees: " << walksLike(mapped, numbers)
+              << std::endl;
+  }
+
+  std::ifstream wordFile("twl.txt");
+  if (!wordFile) return 1;
+  std::vector<std::string> words;
+  std::string word;
+  while (std::getline(wordFile, word)) words.push_back(word);
+  btree<std::string> dictionary(words.begin(), words.end());
+  std::cout << "saved words: " << dictionary.save("test17.words.map")
+            << std::endl;
+  {
+    mapped_btree<std::string> mapped("test17.words.map");
+    size_t found = 0;
+    for (const std::string& w : words) found += mapped.contains(w);
+    std::cout << "words found: " << found << " of " << mapped.size()
+              << ", missing word found: " << mapped.contains("AAAAA")
+              << ", walk agrees: " << walksLike(mapped, dictionary)
+              << std::endl;
+  }
+
+  mapped_btree<std::string> wrongKind("test17.numbers.map");
+  mapped_btree<double> wrongType("test17.numbers.map");
+  mapped_btree<unsigned long> wrongSign("test17.numbers.map");
+  mapped_btree<long> missing("test17.missing.map");
+  btree<long> none;
+  none.save("test17.empty.map");
+  mapped_btree<long> empty("test17.empty.map");
+  std::cout << "wrong key kind open: " << wrongKind.is_open()
+            << ", missing file open: " << missing.is_open()
+            << ", empty tree open: " << empty.is_open() << " with "
+            << empty.size() << " elements, begin == end: "
+            << (empty.begin() == empty.end()) << std::endl;
+  std::cout << "long file as double open: " << wrongType.is_open()
+            << ", as unsigned long open: " << wrongSign.is_open() << std::endl;
+
+  btree<wide> wides;
+  for (long i = 0; i < 10000; ++i) wides.insert(wide{i * 3});
+  wides.save("test17.wide.map");
+  {
+    mapped_btree<wide> mapped("test17.wide.map");
+    bool aligned = true;
+    size_t found = 0;
+    for (long i = 0; i < 10000; ++i) {
+      auto iter = mapped.find(wide{i * 3});
+      found += iter != mapped.end();
+      aligned = aligned && reinterpret_cast<uintptr_t>(&*iter) % 16 == 0;
+    }
+    std::cout << "16-byte aligned keys found: " << found << ", aligned: "
+              << aligned << ", walk agrees: " << walksLike(mapped, wides)
+              << std::endl;
+  }
+
+  btree<long> odds;
+  btree<long> evens;
+  for (long i = 0; i < 50000; ++i) {
+    odds.insert(2 * i + 1);
+    evens.insert(2 * i);
+  }
+  std::vector<std::thread> savers;
+  for (const btree<long> *tree : {&odds, &evens}) {
+    savers.emplace_back([tree]() {
+      for (int i = 0; i < 20; ++i) tree->save("test17.shared.map");
+    });
+  }
+  for (auto& saver : savers) saver.join();
+  {
+    mapped_btree<long> mapped("test17.shared.map");
+    bool whole = mapped.is_open() && (walksLike(mapped, odds)
+                                      || walksLike(mapped, evens));
+    std::cout << "saved from two threads at once, one tree whole: " << whole
+              << std::endl;
+  }
+
+  numbers.save("test17.numbers.map");
+  dictionary.save("test17.words.map");
+  btree_file_header header;
+  {
+    std::ifstream in("test17.numbers.map", std::ios::binary);
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  }
+  size_t rootPage = (header.root + 1) * header.pageBytes;
+  size_t children = rootPage + btree_file_children_offset(header);
+  uint32_t huge = 0xffffffff;
+  uint32_t self = static_cast<uint32_t>(header.root);
+  uint64_t farOff[2] = {1ull << 40, 5};
+  std::vector<long> numberProbes = {-1, 0, 1, 4242, 2 * kNumElems};
+  damage("test17.numbers.map", "test17.bad.map", rootPage, &huge
+       , sizeof(huge));
+  bool badSize = survives<long>("test17.bad.map", numberProbes);
+  damage("test17.numbers.map", "test17.bad.map", children, &huge
+       , sizeof(huge));
+  bool badChild = survives<long>("test17.bad.map", numberProbes);
+  damage("test17.numbers.map", "test17.bad.map", children + sizeof(self)
+       , &self, sizeof(self));
+  bool cycle = survives<long>("test17.bad.map", numberProbes);
+  damage("test17.words.map", "test17.bad.map"
+       , header.pageBytes + header.keyOffset, farOff, sizeof(farOff));
+  bool badString = survives<std::string>("test17.bad.map", words);
+  // a node count whose pages would wrap past 2^64 bytes, and a root in it
+  uint64_t manyNodes[2] = {5000000, 1ull << 52};
+  damage("test17.numbers.map", "test17.bad.map"
+       , offsetof(btree_file_header, root), manyNodes, sizeof(manyNodes));
+  bool tooMany = !mapped_btree<long>("test17.bad.map").is_open();
+  std::remove("test17.bad.map");
+  {
+    mapped_btree<long> sound("test17.numbers.map");
+    std::cout << "sound file verifies: " << sound.verify()
+              << ", damaged size, child, cycle and string caught: "
+              << badSize << badChild << cycle << badString
+              << ", too many nodes refused: " << tooMany << std::endl;
+  }
+
+  std::remove("test17.shared.map");
+  std::remove("test17.numbers.map");
+  std::remove("test17.words.map");
+  std::remove("test17.empty.map");
+  std::remove("test17.wide.map");
+  return 0;
+}
@@ -0,0 +1,69 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "btree.h"
+#include "word_btree.h"
+
+/**
+ * Loads the word list into a word_btree and checks it against a
+ * btree<std::string> read line by line: the same words in the same order.
+ * Then merges in a second file with '\r\n' line ends, blank lines and
+ * words already there, inserts single words, moves the set, and tries a
+ * file that doesn't exist.
+ **/
+
+int main(void) {
+  std::ifstream wordFile("twl.txt");
+  if (!wordFile) return 1;
+  btree<std::string> expected;
+  std::string word;
+  while (std::getline(wordFile, word)) expected.insert(word);
+
+  word_btree<> words;
+  std::cout << "loaded: " << words.load("twl.txt") << ", size "
+            << words.size() << " of " << expected.size() << std::endl;
+  bool same = words.size() == expected.size();
+  auto next = expected.begin();
+  for (std::string_view w : words) {
+    same = same && next != expected.end() && w == *next;
+    ++next;
+  }
+  std::cout << "same words in order: " << same << std::endl;
+
+  {
+    std::ofstream extra("test18.words.txt", std::ios::binary);
+    extra << "zzyzx\r\n\r\n" << *expected.begin() << "\r\naardwolf\r\n\nqi";
+  }
+  size_t before = words.size();
+  std::cout << "merged: " << words.load("test18.words.txt") << ", new words "
+            << words.size() - before << ", has aardwolf "
+            << words.contains("aardwolf") << ", has zzyzx "
+            << words.contains("zzyzx") << ", has qi " << words.contains("qi")
+            << ", has empty word " << words.contains("") << std::endl;
+  std::remove("test18.words.txt");
+
+  std::string longWord(100000, 'x');
+  auto first = words.insert(std::string("zebrawood"));
+  std::cout << "inserted: " << first.second << " " << *first.first;
+  std::cout << ", again: " << words.insert("zebrawood").second;
+  auto big = words.insert(longWord);
+  std::cout << ", long word: " << big.second << " "
+            << (*big.first == longWord) << std::endl;
+
+  word_btree<> moved(std::move(words));
+  std::cout << "moved: " << moved.size() << " words, " << words.size()
+            << " left behind, still finds zebrawood "
+            << moved.contains("zebrawood") << std::endl;
+  words.insert("reused");
+  moved = std::move(words);
+  std::cout << "move assigned: " << moved.size() << " word, "
+            << *moved.begin() << std::endl;
+
+  std::cout << "missing file loaded: " << moved.load("test18.missing.txt")
+            << ", size " << moved.size() << std::endl;
+  return 0;
+}
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "btree.h"
+#include "prefix_btree.h"
+
+/**
+ * Builds prefix_btrees from the word list and from families of keys that
+ * share long prefixes, at several node sizes, and checks find, contains,
+ * lower_bound and a full ordered walk against a std::set of the same
+ * keys, probing with the keys, with keys cut short or run on, and with
+ * strings that sort before and after everything.
+ **/
+
+static_assert(std::is_same<std::iterator_traits<prefix_btree::const_iterator>
+                             ::iterator_category
+                         , std::input_iterator_tag>::value
+            , "keys come back by value, so the iterator is only an input one");
+
+namespace {
+
+std::vector<std::string> probesFor(const std::set<std::string>& keys) {
+  std::vector<std::string> probes = {"", "\x01", "~~~~", "zzzzzzzz"};
+  for (const std::string& key : keys) {
+    probes.push_back(key);
+    probes.push_back(key + "a");
+    probes.push_back(key + '\0');
+    if (!key.empty()) {
+      probes.push_back(key.substr(0, key.size() - 1));
+      std::string bumped = key;
+      ++bumped.back();
+      probes.push_back(bumped);
+    }
+  }
+  return probes;
+}
+
+bool agrees(const prefix_btree& tree, const std::set<std::string>& keys) {
+  if (tree.size() != keys.size()
+      || !std::equal(tree.begin(), tree.end(), keys.begin(), keys.end())) {
+    return false;
+  }
+  for (const std::string& probe : probesFor(keys)) {
+    auto bound = tree.lower_bound(probe);
+    auto expected = keys.lower_bound(probe);
+    bool present = keys.count(probe) > 0;
+    if ((bound == tree.end()) != (expected == keys.end())
+        || (bound != tree.end() && *bound != *expected)
+        || tree.contains(probe) != present
+        || (tree.find(probe) != tree.end()) != present
+        || (present && *tree.find(probe) != probe)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace close
+
+int main(void) {
+  std::ifstream wordFile("twl.txt");
+  if (!wordFile) return 1;
+  std::vector<std::string> words;
+  std::string word;
+  while (std::getline(wordFile, word)) words.push_back(word);
+  std::set<std::string> wordSet(words.begin(), words.end());
+
+  std::set<std::string> family;
+  for (const std::string& w : words) {
+    for (const char *ending : {"", "s", "ed", "ing", "ingly", "ness"}) {
+      family.insert("dictionary/entries/" + w + ending);
+    }
+  }
+
+  for (size_t maxNodeElems : {2, 3, 8, 40, 200}) {
+    prefix_btree dictionary(words.rbegin(), words.rend(), maxNodeElems);
+    prefix_btree prefixed(family.begin(), family.end(), maxNodeElems);
+    std::cout << "node size " << maxNodeElems << ": words "
+              << dictionary.size() << " height " << dictionary.height()
+              << " agree " << agrees(dictionary, wordSet) << ", family "
+              << prefixed.size() << " height " << prefixed.height()
+              << " agree " << agrees(prefixed, family) << std::endl;
+  }
+
+  size_t familyBytes = 0;
+  for (const std::string& key : family) familyBytes += key.size();
+  prefix_btree packed(family.begin(), family.end());
+  std::cout << "family key bytes " << familyBytes << ", packed into "
+            << packed.bytes() << ": "
+            << (packed.bytes() < familyBytes / 2 ? "under" : "over")
+            << " half" << std::endl;
+
+  std::vector<std::string> repeats = {"b", "a", "b", "", "a", ""};
+  prefix_btree small(repeats.begin(), repeats.end());
+  std::vector<std::string> none;
+  prefix_btree empty(none.begin(), none.end());
+  std::cout << "repeats kept once: " << small.size() << ", has empty string "
+            << small.contains("") << ", empty tree size " << empty.size()
+            << " begin == end " << (empty.begin() == empty.end())
+            << " finds nothing " << (empty.find("a") == empty.end())
+            << std::endl;
+
+  prefix_btree copy = packed;
+  std::cout << "copy agrees: " << agrees(copy, family) << std::endl;
+  return 0;
+}
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+
+/**
+ * stats() on trees of known shape: bulk loaded full and half full,
+ * filled in order, and emptied again. Then the counters of instrumented
+ * trees, plain and counted, through inserts, finds, batch lookups,
+ * copies and a reset.
+ **/
+
+namespace {
+
+struct counted_instrumented : btree_counted_policy {
+  static constexpr bool instrumented = true;
+};
+
+template <typename Tree>
+void printStats(const std::string& name, const Tree& tree) {
+  btree_stats stats = tree.stats();
+  std::cout << name << ": size " << stats.size << ", height " << stats.height
+            << ", nodes " << stats.nodes << ", levels";
+  for (size_t nodes : stats.levelNodes) std::cout << " " << nodes;
+  std::cout << ", fill";
+  for (size_t count : stats.fillHistogram) std::cout << " " << count;
+  std::cout << " (" << static_cast<int>(stats.fill * 100 + 0.5) << "%)"
+            << ", bytes per key " << (stats.bytesPerKey > 0) << std::endl;
+}
+
+void printCounters(const std::string& name, const btree_counters& counters) {
+  std::cout << name << ": lookups " << counters.lookups << ", nodes visited "
+            << counters.nodesVisited << ", comparisons "
+            << counters.comparisons << ", splits " << counters.splits
+            << ", allocations " << counters.allocations << std::endl;
+}
+
+}  // namespace close
+
+int main(void) {
+  std::vector<long> elems;
+  for (long i = 0; i < 10000; ++i) elems.push_back(i);
+
+  btree<long> full(10);
+  full.bulk_load(elems.begin(), elems.end());
+  printStats("bulk loaded, full", full);
+  btree<long> half(10);
+  half.bulk_load(elems.begin(), elems.end(), 0.5);
+  printStats("bulk loaded, half", half);
+
+  btree<long> ordered(10);
+  for (long elem : elems) ordered.insert(elem);
+  printStats("inserted in order", ordered);
+  for (long elem : elems) ordered.erase(elem);
+  printStats("erased", ordered);
+
+  btree_stats stats = full.stats();
+  size_t levelSum = 0;
+  size_t fillSum = 0;
+  for (size_t nodes : stats.levelNodes) levelSum += nodes;
+  for (size_t count : stats.fillHistogram) fillSum += count;
+  std::cout << "levels and histogram add up: "
+            << (levelSum == stats.nodes && fillSum == stats.nodes)
+            << ", bytes cover the keys: "
+            << (stats.bytes >= stats.size * sizeof(long)) << std::endl;
+
+  btree<long, std::less<long>, std::allocator<long>
+      , btree_instrumented_policy> counted(4);
+  for (long i = 1; i <= 1000; ++i) counted.insert(i);
+  printCounters("1000 inserts in order", counted.counters());
+  counted.reset_counters();
+  for (long i = 1; i <= 1000; ++i) counted.find(i);
+  btree_counters finds = counted.counters();
+  printCounters("1000 finds", finds);
+  std::cout << "comparisons per find "
+            << finds.comparisons / static_cast<double>(finds.lookups)
+            << ", nodes per find "
+            << finds.nodesVisited / static_cast<double>(finds.lookups)
+            << ", height " << counted.height() << std::endl;
+
+  counted.reset_counters();
+  std::vector<long> probes = {0, 1, 500, 1000, 1001};
+  std::vector<const long*> found(probes.size());
+  counted.find_batch(probes.begin(), probes.end(), found.begin());
+  printCounters("find_batch of 5", counted.counters());
+
+  auto copy = counted;
+  copy.insert(2000);
+  printCounters("copy after one insert", copy.counters());
+  printCounters("original after the copy's insert", counted.counters());
+
+  auto target = copy;
+  target.find(1);
+  target = std::move(copy);
+  printCounters("moved into", target.counters());
+  printCounters("moved from", copy.counters());
+
+  btree<long, std::less<long>, std::allocator<long>
+      , counted_instrumented> ranked(4);
+  for (long i = 1000; i > 0; --i) ranked.insert(i);
+  printCounters("counted tree, 1000 inserts in reverse", ranked.counters());
+  std::cout << "rank of 500: " << ranked.rank(500) << std::endl;
+  printStats("counted tree", ranked);
+  return 0;
+}
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+
+/**
+ * Node capacities fixed at compile time: the unrolled in-node searches,
+ * plain and three-way, against std::lower_bound for every node size up
+ * to its capacity, then fixed_btree and fitted trees put through random
+ * inserts, erases and lookups alongside a std::set, for long keys,
+ * string keys and a comparator of their own. The constructor's
+ * maxNodeElems is ignored by them, which stats() shows.
+ **/
+
+namespace {
+
+template <size_t N>
+bool fixedSearchAgrees() {
+  std::vector<int> keys(N);
+  for (size_t size = 0; size <= N; ++size) {
+    for (size_t i = 0; i < size; ++i) keys[i] = 2 * static_cast<int>(i) + 1;
+    for (int probe = 0; probe <= 2 * static_cast<int>(size) + 1; ++probe) {
+      size_t expected = std::lower_bound(keys.begin(), keys.begin() + size
+                                       , probe) - keys.begin();
+      size_t got = btree_lower_bound_fixed<N>(keys.data(), size, probe
+                                            , std::less<int>());
+      bool found = false;
+      size_t threeWay = btree_lower_bound_fixed<N>(
+          keys.data(), size, probe
+        , [](int key, int elem) { return (key > elem) - (key < elem); }
+        , found);
+      bool present = expected < size && keys[expected] == probe;
+      if (got != expected || threeWay != expected || found != present) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <typename Tree, typename Key, typename MakeKey>
+bool matchesSet(Tree tree, MakeKey makeKey) {
+  std::set<Key, typename Tree::key_compare> expected;
+  std::mt19937_64 rng(6771);
+  for (size_t round = 0; round < 20000; ++round) {
+    Key key = makeKey(rng() % 3000);
+    switch (rng() % 4) {
+      case 0:
+      case 1:
+        if (tree.insert(key).second != expected.insert(key).second) {
+          return false;
+        }
+        break;
+      case 2:
+        if (tree.erase(key) != expected.erase(key)) return false;
+        break;
+      default: {
+        auto bound = tree.lower_bound(key);
+        auto expectedBound = expected.lower_bound(key);
+        if ((bound == tree.end()) != (expectedBound == expected.end())
+            || (bound != tree.end() && *bound != *expectedBound)
+            || (tree.find(key) != tree.end()) != (expected.count(key) > 0)) {
+          return false;
+        }
+      }
+    }
+  }
+  return tree.size() == expected.size()
+      && std::equal(tree.begin(), tree.end(), expected.begin()
+                  , expected.end());
+}
+
+long number(uint64_t i) {
+  return static_cast<long>(i);
+}
+
+std::string word(uint64_t i) {
+  return "key" + std::to_string(i * 7919 % 3000);
+}
+
+}  // namespace close
+
+int main(void) {
+  std::cout << "fixed search agrees: " << fixedSearchAgrees<2>()
+            << fixedSearchAgrees<3>() << fixedSearchAgrees<8>()
+            << fixedSearchAgrees<40>() << fixedSearchAgrees<64>()
+            << std::endl;
+
+  std::cout << "fixed_btree<long, 4>: "
+            << matchesSet<fixed_btree<long, 4>, long>(
+                   fixed_btree<long, 4>(), number)
+            << ", fixed_btree<long, 40>: "
+            << matchesSet<fixed_btree<long, 40>, long>(
+                   fixed_btree<long, 40>(), number)
+            << ", fixed_btree<std::string, 5>: "
+            << matchesSet<fixed_btree<std::string, 5>, std::string>(
+                   fixed_btree<std::string, 5>(), word)
+            << ", descending: "
+            << matchesSet<fixed_btree<long, 7, std::greater<long>>, long>(
+                   fixed_btree<long, 7, std::greater<long>>(), number)
+            << std::endl;
+
+  typedef btree<long, std::less<long>, std::allocator<long>
+              , btree_fitted_policy<>> fitted_longs;
+  typedef btree<std::string, std::less<std::string>
+              , std::allocator<std::string>
+              , btree_fitted_policy<4096>> fitted_strings;
+  std::cout << "fitted capacity: long in 512 bytes "
+            << btree_fixed_node_elems<long, btree_fitted_policy<>>()
+            << ", string in a page "
+            << btree_fixed_node_elems<std::string, btree_fitted_policy<4096>>()
+            << ", runtime policy "
+            << btree_fixed_node_elems<long, btree_default_policy>()
+            << std::endl;
+  std::cout << "fitted trees: "
+            << matchesSet<fitted_longs, long>(fitted_longs(), number) << " "
+            << matchesSet<fitted_strings, std::string>(fitted_strings(), word)
+            << std::endl;
+
+  std::vector<long> elems;
+  for (long i = 0; i < 620; ++i) elems.push_back(i);
+  fitted_longs packed(elems.begin(), elems.end(), 3);
+  fixed_btree<long, 10> ten(elems.begin(), elems.end(), 1000);
+  btree_stats packedStats = packed.stats();
+  btree_stats tenStats = ten.stats();
+  std::cout << "maxNodeElems ignored: fitted nodes " << packedStats.nodes
+            << " height " << packedStats.height << ", fixed 10 nodes "
+            << tenStats.nodes << " height " << tenStats.height << std::endl;
+
+  fixed_btree<long, 6> copied(elems.begin(), elems.end());
+  fixed_btree<long, 6> copy = copied;
+  copy.erase(5);
+  copied = std::move(copy);
+  std::cout << "copy and move: " << copied.size() << " "
+            << (copied.find(5) == copied.end()) << std::endl;
+  return 0;
+}
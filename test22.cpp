@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "btree.h"
+
+/**
+ * Freezes btrees of odd longs at sizes either side of where a level of
+ * separators is added (16 elements to a leaf block, 17 blocks under a
+ * separator block), and checks find, contains, lower_bound and a walk
+ * over the elements against a std::set, probing every key, every gap
+ * between them and past both ends. Then word lists with a transparent
+ * comparator, probed by string_view, and a tree in descending order.
+ **/
+
+namespace {
+
+template <typename Frozen, typename Set, typename Probe>
+bool agrees(const Frozen& frozen, const Set& set
+          , const std::vector<Probe>& probes) {
+  if (frozen.size() != set.size()
+      || !std::equal(frozen.begin(), frozen.end(), set.begin(), set.end())) {
+    return false;
+  }
+  for (const Probe& probe : probes) {
+    auto bound = frozen.lower_bound(probe);
+    auto expected = set.lower_bound(probe);
+    bool present = set.find(probe) != set.end();
+    if ((bound == frozen.end()) != (expected == set.end())
+        || (bound != frozen.end() && *bound != *expected)
+        || frozen.contains(probe) != present
+        || (frozen.find(probe) != frozen.end()) != present
+        || (present && frozen.find(probe) != bound)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace close
+
+int main(void) {
+  for (long size : {0, 1, 15, 16, 17, 272, 273, 289, 4624, 4625, 100000}) {
+    btree<long> tree(7);
+    std::set<long> set;
+    for (long i = size - 1; i >= 0; --i) {
+      tree.insert(2 * i + 1);
+      set.insert(2 * i + 1);
+    }
+    std::vector<long> probes;
+    for (long probe = -1; probe <= 2 * size + 1; ++probe) {
+      probes.push_back(probe);
+    }
+    frozen_btree<long> frozen = tree.freeze();
+    std::cout << "size " << size << ": height " << frozen.height()
+              << " agree " << agrees(frozen, set, probes) << std::endl;
+  }
+
+  std::ifstream wordFile("twl.txt");
+  if (!wordFile) return 1;
+  std::vector<std::string> words;
+  std::string word;
+  while (std::getline(wordFile, word)) words.push_back(word);
+  btree<std::string, std::less<>> wordTree(words.begin(), words.end());
+  std::set<std::string, std::less<>> wordSet(words.begin(), words.end());
+  std::vector<std::string_view> wordProbes = {"", "~", "zzzzzzzz"};
+  for (const std::string& w : wordSet) {
+    wordProbes.push_back(w);
+    wordProbes.push_back(std::string_view(w).substr(0, w.size() - 1));
+  }
+  frozen_btree<std::string, std::less<>> frozenWords = wordTree.freeze();
+  std::cout << "words: " << frozenWords.size() << " height "
+            << frozenWords.height() << " agree "
+            << agrees(frozenWords, wordSet, wordProbes) << std::endl;
+
+  btree<long, std::greater<long>> descending;
+  std::set<long, std::greater<long>> descendingSet;
+  std::vector<long> descendingProbes;
+  for (long i = 0; i < 1000; ++i) {
+    descending.insert(3 * i);
+    descendingSet.insert(3 * i);
+    descendingProbes.push_back(i * 3 - 1);
+    descendingProbes.push_back(i * 3);
+  }
+  std::cout << "descending agree: "
+            << agrees(descending.freeze(), descendingSet, descendingProbes)
+            << std::endl;
+
+  btree<long> large;
+  for (long i = 0; i < 100000; ++i) large.insert(i);
+  frozen_btree<long> frozen = large.freeze();
+  double bytesPerKey = static_cast<double>(frozen.bytes()) / frozen.size();
+  std::cout << "bytes per key: frozen under 9 " << (bytesPerKey < 9)
+            << ", btree " << (large.stats().bytesPerKey > bytesPerKey ? "more"
+                                                                   : "less")
+            << std::endl;
+
+  frozen_btree<long> copy = frozen;
+  frozen_btree<long> moved = std::move(copy);
+  frozen_btree<long> none;
+  std::cout << "copy and move: " << moved.size() << " "
+            << (*moved.find(4242) == 4242) << ", empty "
+            << (none.begin() == none.end()) << " "
+            << (none.lower_bound(1) == none.end()) << std::endl;
+  large.insert(-1);
+  std::cout << "unchanged by later inserts: " << !frozen.contains(-1)
+            << std::endl;
+  return 0;
+}
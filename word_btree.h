@@ -0,0 +1,288 @@
+#ifndef WORD_BTREE_H
+#define WORD_BTREE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "btree.h"
+
+const size_t kWordArenaBlock = 64 * 1024;
+const size_t kWordReadChunk = 1024 * 1024;
+
+/**
+ * A set of words whose characters all live in an arena the set owns,
+ * keyed by string_views into it. A btree<std::string> gives every word an
+ * allocation of its own, scattered over the heap, and copies it on its
+ * way in; here a node holds just the views, and the words of a loaded
+ * file sit next to each other in the order they were read.
+ *
+ * load reads a whole word file, one word a line, into a single block
+ * sized to the file, in large chunks, and splits the lines where they
+ * lie, with no copy per word. Words inserted one at a time are copied
+ * into smaller blocks that are added as they fill up. Blocks never move
+ * or shrink, so every view stays valid for as long as the set does, and
+ * are only freed with it: erasing isn't offered, as it couldn't give any
+ * memory back.
+ *
+ * Moving a word_btree keeps its views valid; copying is not allowed, as a
+ * copy would have to repoint every view at an arena of its own.
+ */
+template <typename Compare = std::less<>>
+class word_btree {
+public:
+    typedef btree<std::string_view, Compare> tree_type;
+    typedef typename tree_type::const_iterator const_iterator;
+
+    /**
+     * @param maxNodeElems the node size of the underlying btree
+     * @param comp the strict weak ordering of the words
+     */
+    explicit word_btree(size_t maxNodeElems = 40
+                      , const Compare& comp = Compare());
+
+    word_btree(word_btree&& original);
+    word_btree& operator=(word_btree&& original);
+    word_btree(const word_btree&) = delete;
+    word_btree& operator=(const word_btree&) = delete;
+
+    /**
+     * Adds every line of the file at path as a word, ignoring a trailing
+     * '\r' and empty lines. The file is read into the arena as it is and
+     * the words are bulk loaded into an empty set, or merged as one batch
+     * into a set that already has some.
+     *
+     * @return false, leaving the set as it was, if the file couldn't be
+     *         read
+     */
+    bool load(const std::string& path);
+
+    /**
+     * Adds word, copying its characters into the arena, unless it is
+     * already there.
+     */
+    std::pair<const_iterator, bool> insert(std::string_view word);
+
+    const_iterator find(std::string_view word) const;
+    const_iterator lower_bound(std::string_view word) const;
+    bool contains(std::string_view word) const;
+
+    size_t size() const;
+    bool empty() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     * The bytes of arena allocated so far, words and unused room alike.
+     */
+    size_t arena_bytes() const;
+
+    const tree_type& tree() const;
+
+private:
+    char* allocate(size_t bytes);
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t arenaBytes_;
+    char *free_;
+    size_t room_;
+    tree_type tree_;
+};
+
+// word_btree
+template <typename Compare>
+word_btree<Compare>::word_btree(size_t maxNodeElems, const Compare& comp)
+    : blocks_{}
+    , arenaBytes_{0}
+    , free_{nullptr}
+    , room_{0}
+    , tree_{maxNodeElems, comp} {
+}
+
+/**
+ * Takes over original's blocks, which stay where they are, along with
+ * the room left in the last one; original is left empty.
+ */
+template <typename Compare>
+word_btree<Compare>::word_btree(word_btree&& original)
+    : blocks_{std::move(original.blocks_)}
+    , arenaBytes_{std::exchange(original.arenaBytes_, 0)}
+    , free_{std::exchange(original.free_, nullptr)}
+    , room_{std::exchange(original.room_, 0)}
+    , tree_{std::move(original.tree_)} {
+    original.blocks_.clear();
+}
+
+template <typename Compare>
+word_btree<Compare>& word_btree<Compare>::operator=(word_btree&& original) {
+    if (this != &original) {
+        tree_ = std::move(original.tree_);
+        blocks_ = std::move(original.blocks_);
+        original.blocks_.clear();
+        arenaBytes_ = std::exchange(original.arenaBytes_, 0);
+        free_ = std::exchange(original.free_, nullptr);
+        room_ = std::exchange(original.room_, 0);
+    }
+    return *this;
+}
+
+/**
+ * Reads straight into the block in chunks, so the file is only ever held
+ * once, then finds the line ends with memchr.
+ */
+template <typename Compare>
+bool word_btree<Compare>::load(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_t bytes = status.st_size;
+    std::unique_ptr<char[]> block(new char[std::max<size_t>(bytes, 1)]);
+    size_t read = 0;
+    while (read < bytes) {
+        ssize_t got = ::read(fd, block.get() + read
+                           , std::min(kWordReadChunk, bytes - read));
+        if (got <= 0) {
+            break;
+        }
+        read += got;
+    }
+    ::close(fd);
+    if (read < bytes) {
+        return false;
+    }
+
+    std::vector<std::string_view> words;
+    const char *at = block.get();
+    const char *end = at + bytes;
+    while (at < end) {
+        const char *eol = static_cast<const char*>(
+                std::memchr(at, '\n', end - at));
+        const char *next = eol == nullptr ? end : eol + 1;
+        size_t length = (eol == nullptr ? end : eol) - at;
+        if (length > 0 && at[length - 1] == '\r') {
+            --length;
+        }
+        if (length > 0) {
+            words.emplace_back(at, length);
+        }
+        at = next;
+    }
+
+    blocks_.push_back(std::move(block));
+    arenaBytes_ += bytes;
+    if (tree_.empty()) {
+        tree_.bulk_load(words.begin(), words.end());
+    } else {
+        tree_.insert(words.begin(), words.end());
+    }
+    return true;
+}
+
+template <typename Compare>
+std::pair<typename word_btree<Compare>::const_iterator, bool>
+word_btree<Compare>::insert(std::string_view word) {
+    const_iterator found = tree_.find(word);
+    if (found != tree_.cend()) {
+        return std::make_pair(found, false);
+    }
+    std::string_view stored;
+    if (!word.empty()) {
+        char *chars = allocate(word.size());
+        std::memcpy(chars, word.data(), word.size());
+        stored = std::string_view(chars, word.size());
+    }
+    auto inserted = tree_.insert(stored);
+    return std::make_pair(const_iterator(inserted.first), true);
+}
+
+template <typename Compare>
+typename word_btree<Compare>::const_iterator
+word_btree<Compare>::find(std::string_view word) const {
+    return tree_.find(word);
+}
+
+template <typename Compare>
+typename word_btree<Compare>::const_iterator
+word_btree<Compare>::lower_bound(std::string_view word) const {
+    return tree_.lower_bound(word);
+}
+
+template <typename Compare>
+bool word_btree<Compare>::contains(std::string_view word) const {
+    return tree_.find(word) != tree_.cend();
+}
+
+template <typename Compare>
+size_t word_btree<Compare>::size() const {
+    return tree_.size();
+}
+
+template <typename Compare>
+bool word_btree<Compare>::empty() const {
+    return tree_.empty();
+}
+
+template <typename Compare>
+typename word_btree<Compare>::const_iterator
+word_btree<Compare>::begin() const {
+    return tree_.cbegin();
+}
+
+template <typename Compare>
+typename word_btree<Compare>::const_iterator
+word_btree<Compare>::end() const {
+    return tree_.cend();
+}
+
+template <typename Compare>
+size_t word_btree<Compare>::arena_bytes() const {
+    return arenaBytes_;
+}
+
+template <typename Compare>
+const typename word_btree<Compare>::tree_type&
+word_btree<Compare>::tree() const {
+    return tree_;
+}
+
+/**
+ * Carves bytes off the current block, starting a new one when it runs
+ * out. Words longer than a block get a block to themselves, leaving the
+ * current one to carry on.
+ */
+template <typename Compare>
+char* word_btree<Compare>::allocate(size_t bytes) {
+    if (bytes > kWordArenaBlock / 4) {
+        blocks_.emplace_back(new char[bytes]);
+        arenaBytes_ += bytes;
+        return blocks_.back().get();
+    }
+    if (bytes > room_) {
+        blocks_.emplace_back(new char[kWordArenaBlock]);
+        arenaBytes_ += kWordArenaBlock;
+        free_ = blocks_.back().get();
+        room_ = kWordArenaBlock;
+    }
+    char *chars = free_;
+    free_ += bytes;
+    room_ -= bytes;
+    return chars;
+}
+
+#endif